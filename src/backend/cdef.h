@@ -662,6 +662,14 @@ struct Config
 #define TARGET_PentiumPro       7
 #define TARGET_PentiumII        8
 #define TARGET_AMD64            9       (32 or 64 bit mode)
+    unsigned char target_model; // x86-64 processor to schedule 64 bit code for
+#define MODEL_none              0       // don't schedule 64 bit code
+#define MODEL_generic           1       // blend of the others
+#define MODEL_core2             2
+#define MODEL_sandybridge       3
+#define MODEL_haswell           4
+#define MODEL_skylake           5
+#define MODEL_zen               6
 
     short versionint;           // intermediate file version (= VERSIONINT)
     int defstructalign;         // struct alignment specified by command line
@@ -833,6 +841,7 @@ struct Config
 #define CFG4dependent        0x2000000  // dependent / non-dependent lookup
 #define CFG4wchar_is_long    0x4000000  // wchar_t is 4 bytes
 #define CFG4underscore       0x8000000  // prepend _ for C mangling
+#define CFG4regsplit         0x10000000 // split live ranges of register variables
 #define CFGX4           (CFG4optimized | CFG4fastfloat | CFG4fdivcall | \
                          CFG4tempinst | CFG4cacheph | CFG4notempexp | \
                          CFG4stackalign | CFG4dependent)
@@ -499,9 +499,10 @@ AArray *fixlist::start = NULL;
 int fixlist::nodel = 0;
 
 /* The AArray, being hashed on the pointer value of the symbol s, is in a different
- * order from run to run. This plays havoc with trying to compare the .obj file output.
- * When needing to do that, set FLARRAY to 1. This will replace the AArray with a
- * simple (and very slow) linear array. Handy for tracking down compiler issues, though.
+ * order from run to run. outfixlist() sorts the symbols by name, so that the .obj
+ * file output doesn't depend on it.
+ * Setting FLARRAY to 1 replaces the AArray with a simple (and very slow) linear array,
+ * which keeps the order the fixups were added in. Handy for tracking down compiler issues.
  */
 #define FLARRAY 0
 #if FLARRAY
@@ -750,6 +751,22 @@ STATIC int outfixlist_dg(void *parameter, void *pkey, void *pvalue)
     return 0;
 }
 
+#if !FLARRAY
+STATIC int outfixlist_key(void *parameter, void *pkey, void *pvalue)
+{
+    symbol ***ppkey = (symbol ***)parameter;
+    *(*ppkey)++ = *(symbol **)pkey;
+    return 0;
+}
+
+STATIC int outfixlist_cmp(const void *p1, const void *p2)
+{
+    symbol *s1 = *(symbol **)p1;
+    symbol *s2 = *(symbol **)p2;
+    return strcmp(s1->Sident, s2->Sident);
+}
+#endif
+
 void outfixlist()
 {
     //printf("outfixlist()\n");
@@ -763,8 +780,29 @@ void outfixlist()
 #else
     if (fixlist::start)
     {
+        /* Define the externals in name order rather than in the
+         * order of the hash table, which varies from run to run.
+         * Putting a static in BSS can add more fixups, so go around
+         * again for those.
+         */
         fixlist::nodel++;
-        fixlist::start->apply(NULL, &outfixlist_dg);
+        size_t done = 0;
+        while (fixlist::start->length() > done)
+        {
+            size_t dim = fixlist::start->length();
+            symbol **keys = (symbol **)mem_malloc(dim * sizeof(symbol *));
+            symbol **pkey = keys;
+            fixlist::start->apply(&pkey, &outfixlist_key);
+            qsort(keys, dim, sizeof(symbol *), &outfixlist_cmp);
+            for (size_t i = 0; i < dim; i++)
+            {
+                fixlist **pv = (fixlist **)fixlist::start->in(&keys[i]);
+                if (!done || *pv)
+                    outfixlist_dg(NULL, &keys[i], pv);
+            }
+            mem_free(keys);
+            done = dim;
+        }
         fixlist::nodel--;
 #if TERMCODE
         delete fixlist::start;
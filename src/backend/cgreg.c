@@ -27,6 +27,9 @@ static char __file__[] = __FILE__;      /* for tassert.h                */
 #include        "tassert.h"
 
 STATIC void el_weights(int bi,elem *e,unsigned weight);
+STATIC int cgreg_lvregbenefit(Symbol *s,int reg,Symbol *retsym);
+STATIC void cgreg_unfl(Symbol *s);
+STATIC int cgreg_split(Symbol *s,int reg,Symbol *retsym,bool commit);
 
 #ifndef __DMC__
 #undef __cdecl
@@ -36,6 +39,7 @@ STATIC void el_weights(int bi,elem *e,unsigned weight);
 static int __cdecl weight_compare(const void *e1,const void *e2);
 
 static int nretblocks;
+static unsigned nspillmoves;            // spill moves generated in the final pass, for -v
 
 static vec_t regrange[REGMAX];
 
@@ -56,6 +60,7 @@ void cgreg_init()
     assert(weights);
 
     nretblocks = 0;
+    nspillmoves = 0;
     for (int bi = 0; bi < dfotop; bi++)
     {   block *b = dfo[bi];
         if (b->BC == BCret || b->BC == BCretexp)
@@ -131,6 +136,25 @@ void cgreg_term()
 {
     if (config.flags4 & CFG4optimized)
     {
+        if (configv.verbose)
+        {   // Report where the register candidates ended up
+            unsigned nreg = 0;
+            unsigned nsplit = 0;
+            unsigned nmem = 0;
+            for (size_t i = 0; i < globsym.top; i++)
+            {
+                Symbol *s = globsym.tab[i];
+                if (s->Sflags & SFLspill)
+                    nsplit++;
+                else if (s->Sfl == FLreg)
+                    nreg++;
+                else if (s->Sflags & GTregcand)
+                    nmem++;
+            }
+            printf("regalloc  %s: %u in registers, %u split, %u in memory, %u spill moves\n",
+                funcsym_p->Sident, nreg, nsplit, nmem, nspillmoves);
+        }
+
         for (size_t i = 0; i < globsym.top; i++)
         {
             Symbol *s = globsym.tab[i];
@@ -239,6 +263,20 @@ STATIC void el_weights(int bi,elem *e,unsigned weight)
  */
 
 int cgreg_benefit(Symbol *s,int reg, Symbol *retsym)
+{
+    //printf("cgreg_benefit(s = '%s', reg = %d)\n", s->Sident, reg);
+
+    vec_sub(s->Slvreg,s->Srange,regrange[reg]);
+    return cgreg_lvregbenefit(s,reg,retsym);
+}
+
+/*****************************************
+ * Same as cgreg_benefit(), but s is to be in reg only for the blocks
+ * already in s->Slvreg. Blocks are removed from s->Slvreg where the
+ * loads and stores between register and memory cannot be placed.
+ */
+
+STATIC int cgreg_lvregbenefit(Symbol *s,int reg,Symbol *retsym)
 {
     int benefit;
     int benefit2;
@@ -247,9 +285,6 @@ int cgreg_benefit(Symbol *s,int reg, Symbol *retsym)
     int gotoepilog;
     int retsym_cnt;
 
-    //printf("cgreg_benefit(s = '%s', reg = %d)\n", s->Sident, reg);
-
-    vec_sub(s->Slvreg,s->Srange,regrange[reg]);
     int si = s->Ssymnum;
 
     regm_t dst_integer_reg;
@@ -538,6 +573,8 @@ Lload:
 #endif
 
         code* c = gen_spill_reg(s, inoutp == 1);
+        if (pass == PASSfinal)
+            nspillmoves++;
 
         if (inoutp == -1)
             cstore = cat(cstore,c);
@@ -602,11 +639,15 @@ void cgreg_spillreg_epilog(block *b,Symbol *s,code **pcstore,code **pcload)
 #endif
 
         code* c = gen_spill_reg(s, inoutp == -1);
+        if (pass == PASSfinal)
+            nspillmoves++;
 
         if (inoutp == 1)
             cstore = cat(cstore,c);
         else
-            cload = cat(cload,c);
+        {   cload = cat(cload,c);
+            regcon.params &= ~s->Sregm;     // parameter no longer in that register
+        }
         break;
     }
 
@@ -615,6 +656,141 @@ void cgreg_spillreg_epilog(block *b,Symbol *s,code **pcstore,code **pcload)
     *pcload = cload;
 }
 
+/****************************************
+ * Symbol s is no longer in a register for all of its live range,
+ * so set Sfl back to where s lives in memory.
+ */
+
+STATIC void cgreg_unfl(Symbol *s)
+{
+    switch (s->Sclass)
+    {
+        case SCauto:
+        case SCregister:
+            s->Sfl = FLauto;
+            break;
+        case SCfastpar:
+            s->Sfl = FLfast;
+            break;
+        case SCbprel:
+            s->Sfl = FLbprel;
+            break;
+        case SCshadowreg:
+        case SCparameter:
+            s->Sfl = FLpara;
+            break;
+#if PSEUDO_REGS
+        case SCpseudo:
+            s->Sfl = FLpseudo;
+            break;
+#endif
+        case SCstack:
+            s->Sfl = FLstack;
+            break;
+        default:
+#ifdef DEBUG
+            symbol_print(s);
+#endif
+            assert(0);
+    }
+}
+
+/*****************************************
+ * Can the live range of symbol s in register reg be split around
+ * another symbol?
+ */
+
+STATIC bool cgreg_splittable(Symbol *s,int reg,Symbol *retsym)
+{
+    return s->Sflags & GTregcand &&
+           (s->Sfl == FLreg || s->Sflags & SFLspill) &&
+           !(s->Sflags & GTunregister) &&
+           s->Sreglsw == reg &&
+           s->Sregm == mask[reg] &&             // not register pairs
+           s != retsym;
+}
+
+/*****************************************
+ * Determine benefit of assigning symbol s to register reg when the
+ * symbols already in reg are moved to memory in the blocks where they
+ * are live but not referenced, so their live ranges are split around s.
+ * If commit, split them.
+ * Returns:
+ *      benefit less what the split symbols lose, -1 if nothing can be split
+ */
+
+STATIC int cgreg_split(Symbol *s,int reg,Symbol *retsym,bool commit)
+{
+    vec_t used = vec_clone(regrange[reg]);
+    int nsplit = 0;
+    for (size_t si = 0; si < globsym.top; si++)
+    {   Symbol *sp = globsym.tab[si];
+
+        if (cgreg_splittable(sp,reg,retsym))
+        {   size_t bi;
+            foreach (bi,dfotop,sp->Slvreg)
+            {
+                if (WEIGHTS(bi,sp->Ssymnum) == 0)
+                {   vec_clearbit(bi,used);
+                    nsplit++;
+                }
+            }
+        }
+    }
+    if (nsplit)
+    {   // reg still holds parameters passed in it where they are live
+        for (size_t si = 0; si < globsym.top; si++)
+        {   Symbol *sp = globsym.tab[si];
+
+            if ((sp->Sclass == SCfastpar || sp->Sclass == SCshadowreg) &&
+                sp->Spregm() & mask[reg] &&
+                sp->Srange)
+                vec_orass(used,sp->Srange);
+        }
+    }
+
+    int benefit = -1;
+    if (nsplit)
+    {   vec_sub(s->Slvreg,s->Srange,used);
+        benefit = cgreg_lvregbenefit(s,reg,retsym);
+    }
+    if (benefit > 0)
+    {   vec_t lvreg = vec_calloc(dfotop);
+        for (size_t si = 0; si < globsym.top; si++)
+        {   Symbol *sp = globsym.tab[si];
+
+            if (!cgreg_splittable(sp,reg,retsym) ||
+                vec_disjoint(sp->Slvreg,s->Slvreg))
+                continue;
+
+            vec_copy(lvreg,sp->Slvreg);
+            int before = cgreg_lvregbenefit(sp,reg,retsym);
+            vec_sub(sp->Slvreg,lvreg,s->Slvreg);
+            benefit -= before - cgreg_lvregbenefit(sp,reg,retsym);
+            if (commit)
+            {
+                #ifdef DEBUG
+                if (debugr)
+                {   printf("symbol '%s' split around '%s' in register %s\n    ",
+                        sp->Sident,s->Sident,regstring[reg]);
+                    vec_println(sp->Slvreg);
+                }
+                #endif
+                vec_subass(lvreg,sp->Slvreg);   // the blocks sp gives up
+                vec_subass(regrange[reg],lvreg);
+                if (sp->Sfl == FLreg)
+                    cgreg_unfl(sp);
+                sp->Sflags |= SFLspill;
+            }
+            else
+                vec_copy(sp->Slvreg,lvreg);
+        }
+        vec_free(lvreg);
+    }
+    vec_free(used);
+    return benefit;
+}
+
 /***************************
  * Map symbol s into registers [NOREG,reglsw] or [regmsw, reglsw].
  */
@@ -638,38 +814,7 @@ void cgreg_map(Symbol *s, unsigned regmsw, unsigned reglsw)
         //vec_sub(s->Slvreg,s->Srange,regrange[reglsw]);
 
         if (s->Sfl == FLreg)            // if reassigned
-        {
-            switch (s->Sclass)
-            {
-                case SCauto:
-                case SCregister:
-                    s->Sfl = FLauto;
-                    break;
-                case SCfastpar:
-                    s->Sfl = FLfast;
-                    break;
-                case SCbprel:
-                    s->Sfl = FLbprel;
-                    break;
-                case SCshadowreg:
-                case SCparameter:
-                    s->Sfl = FLpara;
-                    break;
-#if PSEUDO_REGS
-                case SCpseudo:
-                    s->Sfl = FLpseudo;
-                    break;
-#endif
-                case SCstack:
-                    s->Sfl = FLstack;
-                    break;
-                default:
-#ifdef DEBUG
-                    symbol_print(s);
-#endif
-                    assert(0);
-            }
-        }
+            cgreg_unfl(s);
     }
     s->Sreglsw = reglsw;
     s->Sregm = mask[reglsw];
@@ -740,6 +885,7 @@ struct Reg              // data for trial register assignment
     int reglsw;
     int regmsw;
     int benefit;
+    bool split;                 // split the live ranges of the symbols in reglsw
 };
 
 int cgreg_assign(Symbol *retsym)
@@ -767,42 +913,12 @@ int cgreg_assign(Symbol *retsym)
             flag = TRUE;
             s->Sflags &= ~(GTregcand | GTunregister | SFLspill);
             if (s->Sfl == FLreg)
-            {
-                switch (s->Sclass)
-                {
-                    case SCauto:
-                    case SCregister:
-                        s->Sfl = FLauto;
-                        break;
-                    case SCfastpar:
-                        s->Sfl = FLfast;
-                        break;
-                    case SCbprel:
-                        s->Sfl = FLbprel;
-                        break;
-                    case SCshadowreg:
-                    case SCparameter:
-                        s->Sfl = FLpara;
-                        break;
-#if PSEUDO_REGS
-                    case SCpseudo:
-                        s->Sfl = FLpseudo;
-                        break;
-#endif
-                    case SCstack:
-                        s->Sfl = FLstack;
-                        break;
-                    default:
-#ifdef DEBUG
-                        symbol_print(s);
-#endif
-                        assert(0);
-                }
-            }
+                cgreg_unfl(s);
         }
     }
 
     vec_t v = vec_calloc(dfotop);
+    vec_t vlv = vec_calloc(dfotop);
 
     unsigned dst_integer_reg;
     unsigned dst_float_reg;
@@ -815,6 +931,7 @@ int cgreg_assign(Symbol *retsym)
     Reg t;
     t.sym = NULL;
     t.benefit = 0;
+    t.split = false;
     for (size_t si = 0; si < globsym.top; si++)
     {   symbol *s = globsym.tab[si];
 
@@ -856,6 +973,7 @@ int cgreg_assign(Symbol *retsym)
         cgreg_set_priorities(ty, &pseq, &pseqmsw);
 
         u.benefit = 0;
+        u.split = false;
         for (int i = 0; pseq[i] != NOREG; i++)
         {
             unsigned reg = pseq[i];
@@ -888,6 +1006,20 @@ int cgreg_assign(Symbol *retsym)
             }
             #endif
 
+            // See if it's better to split the symbols already in reg around s
+            bool split = false;
+            if (config.flags4 & CFG4regsplit && !pseqmsw && s != retsym)
+            {
+                vec_copy(vlv,s->Slvreg);
+                int benefit2 = cgreg_split(s,reg,retsym,false);
+                if (benefit2 > benefit)
+                {   benefit = benefit2;
+                    split = true;
+                }
+                else
+                    vec_copy(s->Slvreg,vlv);
+            }
+
             if (benefit > u.benefit)
             {   // successful assigning of lsw
                 unsigned regmsw = NOREG;
@@ -916,6 +1048,7 @@ int cgreg_assign(Symbol *retsym)
                 u.benefit = benefit;
                 u.reglsw = reg;
                 u.regmsw = regmsw;
+                u.split = split;
             }
 Ltried:     ;
         }
@@ -928,6 +1061,8 @@ Ltried:     ;
 
     if (t.sym && t.benefit > 0)
     {
+        if (t.split)
+            cgreg_split(t.sym,t.reglsw,retsym,true);
         cgreg_map(t.sym,t.regmsw,t.reglsw);
         flag = TRUE;
     }
@@ -962,6 +1097,7 @@ Ltried:     ;
         }
     }
     vec_free(v);
+    vec_free(vlv);
 
     return flag;
 }
@@ -75,6 +75,7 @@ struct Cinfo
 code *simpleops(code *c,regm_t scratch);
 code *schedule(code *c,regm_t scratch);
 code *peephole(code *c,regm_t scratch);
+STATIC code *schedule64(code *c);
 
 /*****************************************
  * Do Pentium optimizations.
@@ -96,6 +97,8 @@ void cgsched_pentium(code **pc,regm_t scratch)
                 *pc = simpleops(*pc,scratch);
             *pc = schedule(*pc,0);
         }
+        else if (I64 && config.target_model != MODEL_none)
+            *pc = schedule64(*pc);
     }
 }
 
@@ -1195,7 +1198,7 @@ STATIC void getinfo(Cinfo *ci,code *c)
     unsigned a32;
     int pc;
     unsigned r,w;
-    int sz = I32 ? 4 : 2;
+    int sz = I16 ? 2 : 4;
 
     ci->r = 0;
     ci->w = 0;
@@ -1203,10 +1206,12 @@ STATIC void getinfo(Cinfo *ci,code *c)
     op = c->Iop & 0xFF;
     if ((c->Iop & 0xFF00) == 0x0F00)
         op = 0x0F;
+    else if (I64 && (c->Iop & 0xFFFF00 || c->Iflags & (CFvex | CFvex3)))
+        op = 0x0F;                      // 3 byte and VEX opcodes are barriers
     //printf("\tgetinfo %x, op %x \n",c,op);
     pc = pentcycl[op];
-    a32 = I32;
-    if (c->Iflags & CFaddrsize)
+    a32 = !I16;
+    if (c->Iflags & CFaddrsize && !I64)
         a32 ^= 1;
     if (c->Iflags & CFopsize)
         sz ^= 2 | 4;
@@ -1215,6 +1220,30 @@ STATIC void getinfo(Cinfo *ci,code *c)
     reg = (irm >> 3) & 7;
     rm = irm & 7;
 
+    /* In 64 bit code, the REX prefix supplies the high bit of the
+     * register numbers, and the presence of any REX prefix means
+     * byte registers 4..7 are SPL..DIL rather than AH..BH.
+     */
+    unsigned rexr = 0;
+    unsigned rexx = 0;
+    unsigned rexb = 0;
+    unsigned bytereg = 3;
+    if (I64)
+    {
+        if (c->Irex & REX_W)
+            sz = 8;
+        if (c->Irex & REX_R)
+            rexr = 8;
+        if (c->Irex & REX_X)
+            rexx = 8;
+        if (c->Irex & REX_B)
+            rexb = 8;
+        if (c->Irex)
+            bytereg = 15;
+    }
+    unsigned xreg = reg | rexr;
+    unsigned xrm = rm | rexb;
+
     r = oprw[op][0];
     w = oprw[op][1];
 
@@ -1229,6 +1258,8 @@ STATIC void getinfo(Cinfo *ci,code *c)
         case 0x57:                              // PUSH reg
             ci->flags |= CIFLpush;
         case 0x54:                              // PUSH ESP
+            if (rexb)                           // PUSH R8..R15
+                r = mask[(op & 7) | 8] | mSP;
         case 0x6A:                              // PUSH imm8
         case 0x68:                              // PUSH imm
         case 0x0E:
@@ -1237,6 +1268,8 @@ STATIC void getinfo(Cinfo *ci,code *c)
         case 0x06:
         case 0x9C:
         Lpush:
+            if (I64)
+                sz = 8;
             ci->spadjust = -sz;
             ci->a |= mSP;
             break;
@@ -1249,11 +1282,15 @@ STATIC void getinfo(Cinfo *ci,code *c)
         case 0x5D:
         case 0x5E:
         case 0x5F:                              // POP reg
+            if (rexb)                           // POP R8..R15
+                w = mask[(op & 7) | 8] | mSP;
         case 0x1F:
         case 0x07:
         case 0x17:
         case 0x9D:                              // POPF
         Lpop:
+            if (I64)
+                sz = 8;
             ci->spadjust = sz;
             ci->a |= mSP;
             break;
@@ -1269,12 +1306,12 @@ STATIC void getinfo(Cinfo *ci,code *c)
         case 0x83:
             if (reg == 7)                       // CMP
                 c->Iflags |= CFpsw;
-            else if (irm == modregrm(3,0,SP))   // ADD ESP,imm
+            else if (irm == modregrm(3,0,SP) && !rexb)  // ADD ESP,imm
             {
                 assert(c->IFL2 == FLconst);
                 ci->spadjust = (op == 0x81) ? c->IEV2.Vint : (signed char)c->IEV2.Vint;
             }
-            else if (irm == modregrm(3,5,SP))   // SUB ESP,imm
+            else if (irm == modregrm(3,5,SP) && !rexb)  // SUB ESP,imm
             {
                 assert(c->IFL2 == FLconst);
                 ci->spadjust = (op == 0x81) ? -c->IEV2.Vint : -(signed char)c->IEV2.Vint;
@@ -1283,6 +1320,48 @@ STATIC void getinfo(Cinfo *ci,code *c)
             w = grprw[0][reg][1];
             break;
 
+        case 0x63:
+            if (I64)                            // MOVSXD r64,EA
+            {   r = EA;
+                w = R;
+            }
+            break;
+
+        case 0x91:
+        case 0x92:
+        case 0x93:
+        case 0x94:
+        case 0x95:
+        case 0x96:
+        case 0x97:                              // XCHG EAX,reg
+            if (rexb)                           // XCHG EAX,R8..R15
+                r = w = mAX | mask[(op & 7) | 8];
+            break;
+
+        case 0xB0:
+        case 0xB1:
+        case 0xB2:
+        case 0xB3:
+        case 0xB4:
+        case 0xB5:
+        case 0xB6:
+        case 0xB7:                              // MOV reg8,imm8
+            if (bytereg != 3)                   // SPL..DIL or R8B..R15B
+                w = mask[(op & 7) | rexb];
+            break;
+
+        case 0xB8:
+        case 0xB9:
+        case 0xBA:
+        case 0xBB:
+        case 0xBC:
+        case 0xBD:
+        case 0xBE:
+        case 0xBF:                              // MOV reg,imm
+            if (rexb)                           // MOV R8..R15,imm
+                w = mask[(op & 7) | 8];
+            break;
+
         case 0x8F:
             if (reg == 0)                       // POP rm
                 goto Lpop;
@@ -1337,6 +1416,45 @@ STATIC void getinfo(Cinfo *ci,code *c)
                 ci->w = N;
                 goto Lret;
             }
+            if (I64 && (c->Iop & 0xFFFF00) == 0x0F00)
+            {   // Integer 2 byte opcodes the 64 bit code generator uses a lot
+                if ((op2 & 0xF0) == 0x40)       // CMOVcc
+                {   r = F | EA | R;
+                    w = R;
+                    break;
+                }
+                if ((op2 & 0xF0) == 0x90)       // SETcc
+                {   r = F;
+                    w = EA | B;
+                    break;
+                }
+                switch (op2)
+                {
+                    case 0xAF:                  // IMUL reg,EA
+                        r = EA | R;
+                        w = F | R;
+                        break;
+
+                    case 0xB6:
+                    case 0xBE:                  // MOVZX/MOVSX reg,EA8
+                        r = EA;
+                        w = R;
+                        if (mod == 3 && bytereg == 3)
+                            r |= mask[rm & 3];  // AH..BH
+                        break;
+
+                    case 0xB7:
+                    case 0xBF:                  // MOVZX/MOVSX reg,EA16
+                        r = EA;
+                        w = R;
+                        break;
+
+                    default:
+                        goto Lbarrier;
+                }
+                break;
+            }
+        Lbarrier:
             ci->r = N;
             ci->w = N;          // copout for now
             goto Lret;
@@ -1553,9 +1671,9 @@ STATIC void getinfo(Cinfo *ci,code *c)
     ci->r = r & ~(R | EA);
     ci->w = w & ~(R | EA);
     if (r & R)
-        ci->r |= mask[(r & B) ? (reg & 3) : reg];
+        ci->r |= mask[(r & B) ? (xreg & bytereg) : xreg];
     if (w & R)
-        ci->w |= mask[(w & B) ? (reg & 3) : reg];
+        ci->w |= mask[(w & B) ? (xreg & bytereg) : xreg];
 
     // OR in bits for EA addressing mode
     if ((r | w) & EA)
@@ -1569,13 +1687,13 @@ STATIC void getinfo(Cinfo *ci,code *c)
                 {
                     if (rm == 4)
                     {   sib = c->Isib;
-                        if ((sib & modregrm(0,7,0)) != modregrm(0,4,0))
-                            ci->a |= mask[(sib >> 3) & 7];      // index register
+                        if ((((sib >> 3) & 7) | rexx) != 4)
+                            ci->a |= mask[((sib >> 3) & 7) | rexx];     // index register
                         if ((sib & 7) != 5)
-                            ci->a |= mask[sib & 7];             // base register
+                            ci->a |= mask[(sib & 7) | rexb];            // base register
                     }
                     else if (rm != 5)
-                        ci->a |= mask[rm];
+                        ci->a |= mask[xrm];
                 }
                 else
                 {   static unsigned char ea16[8] = {mBX|mSI,mBX|mDI,mBP|mSI,mBP|mDI,mSI,mDI,0,mBX};
@@ -1589,12 +1707,12 @@ STATIC void getinfo(Cinfo *ci,code *c)
                 {
                     if (rm == 4)
                     {   sib = c->Isib;
-                        if ((sib & modregrm(0,7,0)) != modregrm(0,4,0))
-                            ci->a |= mask[(sib >> 3) & 7];      // index register
-                        ci->a |= mask[sib & 7];                 // base register
+                        if ((((sib >> 3) & 7) | rexx) != 4)
+                            ci->a |= mask[((sib >> 3) & 7) | rexx];     // index register
+                        ci->a |= mask[(sib & 7) | rexb];                // base register
                     }
                     else
-                        ci->a |= mask[rm];
+                        ci->a |= mask[xrm];
                 }
                 else
                 {   static unsigned char ea16[8] = {mBX|mSI,mBX|mDI,mBP|mSI,mBP|mDI,mSI,mDI,mBP,mBX};
@@ -1611,9 +1729,9 @@ STATIC void getinfo(Cinfo *ci,code *c)
 
             case 3:
                 if (r & EA)
-                    ci->r |= mask[(r & B) ? (rm & 3) : rm];
+                    ci->r |= mask[(r & B) ? (xrm & bytereg) : xrm];
                 if (w & EA)
-                    ci->w |= mask[(w & B) ? (rm & 3) : rm];
+                    ci->w |= mask[(w & B) ? (xrm & bytereg) : xrm];
                 break;
         }
         // Adjust sibmodrm so that addressing modes can be compared simply
@@ -1658,6 +1776,12 @@ STATIC void getinfo(Cinfo *ci,code *c)
         ci->r |= ci->a;
         ci->reg = reg;
         ci->sibmodrm = (sib << 8) | irm;
+        if (I64)
+        {   // Addressing modes are only the same if the high register bits
+            // and segment overrides are too
+            ci->sibmodrm |= (c->Irex & (REX_X | REX_B)) << 16;
+            ci->sibmodrm |= (c->Iflags & CFSEG) << 20;
+        }
     }
 Lret:
     if (ci->w & mSP)                    // if stack pointer is modified
@@ -1899,7 +2023,8 @@ if (c2->IEVpointer1 + sz2 <= c1->IEVpointer1) printf("t5\n");
         }
 
         // If referring to distinct types, then no dependency
-        if (c1->Irex && c2->Irex && c1->Irex != c2->Irex)
+        // (in 64 bit code Irex is the REX prefix instead)
+        if (!I64 && c1->Irex && c2->Irex && c1->Irex != c2->Irex)
             goto Lswap;
 
         ifl1 = c1->IFL1;
@@ -2745,6 +2870,296 @@ code *schedule(code *c,regm_t scratch)
 
 /**************************************************************************/
 
+/**************************************************************************
+ * List scheduler for 64 bit code.
+ * Current x86-64 processors execute out of order, so instead of modelling
+ * pairing, start the long dependency chains (loads, multiplies, divides)
+ * as early as possible and spread the work across the execution ports,
+ * using a small table of latencies and port counts for each processor.
+ */
+
+enum
+{
+    LATalu,             // simple integer operation
+    LATlea,             // LEA with base, index and displacement
+    LATimul,            // integer multiply
+    LATdiv,             // integer divide
+    LATload,            // load from memory, or store to load forwarding
+    LATfpu,             // x87 operation
+    LATmax
+};
+
+struct CpuModel
+{
+    unsigned char width;        // instructions issued per clock
+    unsigned char alus;         // integer ALU ports
+    unsigned char loads;        // load ports
+    unsigned char stores;       // store data ports
+    unsigned char lat[LATmax];  // latency in clocks of each class
+};
+
+/* Indexed by config.target_model - MODEL_generic.
+ * The latencies are rounded from published instruction tables,
+ * only their relative sizes matter.
+ */
+static CpuModel cpumodels[] =
+{
+    //  width alus loads stores    alu lea imul div load fpu
+    {   4,    3,   2,    1,      {  1,  3,  3,  26,  5,  4 } },     // generic
+    {   4,    3,   1,    1,      {  1,  1,  3,  23,  3,  4 } },     // core2
+    {   4,    3,   2,    1,      {  1,  3,  3,  25,  5,  4 } },     // sandybridge
+    {   4,    4,   2,    1,      {  1,  3,  3,  32,  5,  4 } },     // haswell
+    {   4,    4,   2,    1,      {  1,  3,  3,  26,  5,  4 } },     // skylake
+    {   5,    4,   2,    1,      {  1,  2,  3,  20,  4,  5 } },     // zen
+};
+
+#define SCHED64MAX      64      // most instructions in one region (bits in a long long)
+
+/*****************************************
+ * Determine latency class of instruction.
+ */
+
+STATIC int sched64_class(Cinfo *ci)
+{
+    code *c = ci->c;
+    unsigned reg = (c->Irm >> 3) & 7;
+
+    switch (c->Iop)
+    {
+        case 0x0FAF:
+        case 0x69:
+        case 0x6B:                      // IMUL
+            return LATimul;
+
+        case 0xF6:
+        case 0xF7:
+            if (reg == 4 || reg == 5)   // MUL, IMUL
+                return LATimul;
+            if (reg == 6 || reg == 7)   // DIV, IDIV
+                return LATdiv;
+            break;
+
+        case 0x8D:                      // LEA
+            if (issib(c->Irm) && (c->Irm & 0xC0) &&
+                ((((c->Isib >> 3) & 7) | (c->Irex & REX_X ? 8 : 0)) != 4))
+                return LATlea;
+            break;
+
+        default:
+            if ((c->Iop & ~7) == 0xD8)
+                return LATfpu;
+            break;
+    }
+    return LATalu;
+}
+
+/*****************************************
+ * Determine if instruction only moves data to or from memory,
+ * and so needs no ALU.
+ */
+
+STATIC int sched64_move(Cinfo *ci)
+{
+    switch (ci->c->Iop)
+    {
+        case 0x88:
+        case 0x89:
+        case 0x8A:
+        case 0x8B:                      // MOV
+        case 0xC6:
+        case 0xC7:                      // MOV EA,imm
+            return (ci->flags & CIFLea) != 0;
+    }
+    return (ci->c->Iop & 0xF0) == 0x50;         // PUSH, POP
+}
+
+/*****************************************
+ * Schedule one region of n instructions, appending them to *pctail.
+ * Returns:
+ *      new tail
+ */
+
+STATIC code **schedule64_region(Cinfo *ci,int n,code **pctail)
+{
+    CpuModel *m = &cpumodels[config.target_model - MODEL_generic];
+    unsigned long long succ[SCHED64MAX];    // instructions that must come after [i]
+    unsigned long long pred[SCHED64MAX];    // instructions that must come before [i]
+    unsigned lat[SCHED64MAX];           // clocks until result of [i] is ready
+    unsigned height[SCHED64MAX];        // clocks from [i] to end of region
+    unsigned ready[SCHED64MAX];         // earliest clock [i] can issue
+    int order[SCHED64MAX];
+    int lastflags = -1;
+
+    for (int i = 0; i < n; i++)
+    {
+        succ[i] = 0;
+        pred[i] = 0;
+        ready[i] = 0;
+        int move = sched64_move(&ci[i]);
+        lat[i] = move ? 0 : m->lat[sched64_class(&ci[i])];
+        if ((ci[i].r | ci[i].w) & mMEM)
+            lat[i] += m->lat[LATload];
+        if (ci[i].w & F)
+            lastflags = i;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = i + 1; j < n; j++)
+        {
+            if (conflict(&ci[i],&ci[j],0) ||
+                // A label must stay first
+                (i == 0 && ci[i].c->Iflags & (CFtarg | CFtarg2)) ||
+                // The flags may be live past the region, so
+                // keep the last instruction that sets them last
+                (j == lastflags && ci[i].w & F))
+            {
+                succ[i] |= 1ULL << j;
+                pred[j] |= 1ULL << i;
+            }
+        }
+    }
+
+    // Priority is the length of the longest dependency chain to the end
+    for (int i = n; i--;)
+    {
+        height[i] = lat[i];
+        for (int j = i + 1; j < n; j++)
+        {
+            if (succ[i] & (1ULL << j))
+            {
+                unsigned h = height[j];
+                if (ci[i].w & ci[j].r & ~mSP)
+                    h += lat[i];
+                if (h > height[i])
+                    height[i] = h;
+            }
+        }
+    }
+
+    unsigned long long done = 0;
+    int ndone = 0;
+    for (unsigned clock = 0; ndone < n; clock++)
+    {
+        int slots = m->width;
+        int alus = m->alus;
+        int loads = m->loads;
+        int stores = m->stores;
+        int muls = 1;
+        while (slots)
+        {
+            // Pick the ready instruction with the longest chain after it,
+            // earliest first among equals
+            int best = -1;
+            for (int j = 0; j < n; j++)
+            {
+                if (done & (1ULL << j) ||
+                    pred[j] & ~done ||
+                    ready[j] > clock)
+                    continue;
+                int move = sched64_move(&ci[j]);
+                int cls = sched64_class(&ci[j]);
+                if ((!move && !alus) ||
+                    ((ci[j].r & mMEM) && !loads) ||
+                    ((ci[j].w & mMEM) && !stores) ||
+                    ((cls == LATimul || cls == LATdiv) && !muls))
+                    continue;
+                if (best < 0 || height[j] > height[best])
+                    best = j;
+            }
+            if (best < 0)
+                break;
+
+            int cls = sched64_class(&ci[best]);
+            if (!sched64_move(&ci[best]))
+                alus--;
+            if (ci[best].r & mMEM)
+                loads--;
+            if (ci[best].w & mMEM)
+                stores--;
+            if (cls == LATimul || cls == LATdiv)
+                muls--;
+            slots--;
+            done |= 1ULL << best;
+            order[ndone++] = best;
+
+            for (int j = best + 1; j < n; j++)
+            {
+                if (succ[best] & (1ULL << j))
+                {
+                    unsigned t = clock;
+                    if (ci[best].w & ci[j].r & ~mSP)
+                        t += lat[best];         // wait for the result
+                    else if (ci[best].w & ci[j].r)
+                        t += 1;                 // stack engine
+                    if (t > ready[j])
+                        ready[j] = t;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        code *c = ci[order[i]].c;
+        *pctail = c;
+        while (code_next(c))
+            c = code_next(c);
+        pctail = &code_next(c);
+    }
+    return pctail;
+}
+
+/******************************
+ * Schedule x86-64 instructions.
+ */
+
+STATIC code *schedule64(code *c)
+{
+    code *cresult = NULL;
+    code **pctail = &cresult;
+    Cinfo ci[SCHED64MAX];
+
+    while (c)
+    {
+        if ((c->Iop == NOP ||
+             ((c->Iop & ESCAPEmask) == ESCAPE && c->Iop != (ESCAPE | ESCadjfpu)) ||
+             c->Iflags & CFclassinit) &&
+            !(c->Iflags & (CFtarg | CFtarg2)))
+        {   code *cn;
+
+            // Just append this instruction to pctail and go to the next one
+            *pctail = c;
+            cn = code_next(c);
+            code_next(c) = NULL;
+            pctail = &code_next(c);
+            c = cn;
+            continue;
+        }
+
+        // Gather instructions up to the next label or barrier
+        int n = 0;
+        while (c && n < SCHED64MAX)
+        {
+            if (n && c->Iflags & (CFtarg | CFtarg2))
+                break;
+            getinfo(&ci[n],c);
+            int barrier = (ci[n].r | ci[n].w) & N || c->Iflags & CFvolatile;
+            if (barrier && n)
+                break;
+            n++;
+            c = csnip(c);
+            if (barrier)
+                break;
+        }
+        pctail = schedule64_region(ci,n,pctail);
+    }
+
+    return cresult;
+}
+
+/**************************************************************************/
+
 /********************************************
  * Replace any occurrence of r1 in EA with r2.
  */
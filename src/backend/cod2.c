@@ -4166,7 +4166,7 @@ code *getoffset(elem *e,unsigned reg)
             css.Irex = REX | REX_W;
             css.Iop = 0x8D;             // LEA
             css.Irm = modregrm(0,DI,5);
-            css.Iflags = CFopsize;
+            css.Iflags = CFopsize | CFvolatile;  // must stay next to the CALL
             css.IFL1 = fl;
             css.IEVsym1 = e->EV.sp.Vsym;
             css.IEVoffset1 = e->EV.sp.Voffset;
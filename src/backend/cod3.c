@@ -1140,6 +1140,11 @@ code *cmpval(targ_llong val, unsigned sz, unsigned reg, unsigned reg2, unsigned
         {
             assert(sreg != NOREG);
             c = movregconst(CNIL,sreg,val,64);        // MOV sreg,val64
+            /* In a binary tree of compares, which load of sreg was last
+             * executed is not known here, nor after the switch,
+             * so don't let movregconst() track what is in sreg.
+             */
+            regcon.immed.mval &= ~mask[sreg];
             c = genregs(c,0x3B,reg,sreg);             // CMP reg,sreg
             code_orrex(c, REX_W);
         }
@@ -1203,11 +1208,262 @@ code *ifthen(CaseVal *casevals, size_t ncases,
     return c;
 }
 
+/*******************************
+ * Put the cases of switch block b into casevals[0..ncases],
+ * sorted so we can do a runtime binary search.
+ */
+
+static CaseVal *sortcases(block *b, targ_llong *p, size_t ncases)
+{
+    CaseVal *casevals = (CaseVal *)malloc(ncases * sizeof(CaseVal));
+    assert(casevals);
+    list_t bl = b->Bsucc;
+    for (size_t n = 0; n < ncases; n++)
+    {
+        casevals[n].val = p[n];
+        bl = list_next(bl);
+        casevals[n].target = list_block(bl);
+    }
+    qsort(casevals, ncases, sizeof(CaseVal), &CaseVal::cmp);
+    return casevals;
+}
+
+/*******************************
+ * A run of sorted cases that is either a single case, or dense
+ * enough to be dispatched through its own slice of the jump table.
+ */
+
+struct SwitchCluster
+{
+    CaseVal *cases;             // first case of the run
+    size_t ncases;              // number of cases in the run
+    bool jmptab;                // dispatched through the jump table
+    targ_size_t index;          // jump table entry for cases[0].val
+};
+
+#define CLUSTERMIN      4       // fewest cases worth a jump table slice
+
+/*******************************
+ * Divide sorted casevals[0..ncases] into clusters[]. A cluster
+ * is a jump table slice if it has at least CLUSTERMIN cases and
+ * >= 33% of its slice is case values, same as a whole switch
+ * gets a jump table in doswitch().
+ * Must be same computation as used in outjmptab().
+ * Returns:
+ *      number of clusters, and *pentries is set to the
+ *      total number of jump table entries
+ */
+
+static size_t switchclusters(CaseVal *casevals, size_t ncases, bool tables,
+        SwitchCluster *clusters, targ_size_t *pentries)
+{
+    size_t nclusters = 0;
+    targ_size_t entries = 0;
+    for (size_t i = 0; i < ncases; )
+    {
+        // Find the longest run starting at i that is dense enough
+        size_t last = i;
+        if (tables)
+        {
+            for (size_t j = i + CLUSTERMIN - 1; j < ncases; j++)
+            {
+                if (casevals[j].val - casevals[i].val <= (j - i + 1) * 3)
+                    last = j;
+            }
+        }
+
+        SwitchCluster *cl = &clusters[nclusters++];
+        cl->cases = &casevals[i];
+        cl->index = entries;
+        if (last - i + 1 >= CLUSTERMIN)
+        {
+            cl->ncases = last - i + 1;
+            cl->jmptab = true;
+            entries += casevals[last].val - casevals[i].val + 1;
+        }
+        else
+        {
+            cl->ncases = 1;
+            cl->jmptab = false;
+        }
+        i += cl->ncases;
+    }
+    *pentries = entries;
+    return nclusters;
+}
+
+/*******************************
+ * Size in bytes of each jump table entry.
+ */
+
+static unsigned jmptabentsize()
+{
+    if (I64 && (config.flags3 & CFG3pic || config.exe == EX_WIN64))
+        return 4;               // offset from start of table
+    return tysize[TYnptr];
+}
+
+/*******************************
+ * Generate indirect jump through the jump table of b,
+ * indexed by reg.
+ */
+
+static code *jmptabjump(block *b, unsigned reg)
+{
+    code *c = CNIL;
+    code *ce = CNIL;
+    if (I64)
+    {
+        if (config.flags3 & CFG3pic || config.exe == EX_WIN64)
+        {
+            /* LEA    R1,disp[RIP]          48 8D 05 00 00 00 00
+             * MOVSXD R2,[reg*4][R1]        48 63 14 B8
+             * LEA    R1,[R1][R2]           48 8D 04 02
+             * JMP    R1                    FF E0
+             */
+            unsigned r1;
+            regm_t scratchm = ALLREGS & ~mask[reg];
+            c = cat(c, allocreg(&scratchm,&r1,TYint));
+            unsigned r2;
+            scratchm = ALLREGS & ~(mask[reg] | mask[r1]);
+            c = cat(c, allocreg(&scratchm,&r2,TYint));
+
+            ce = genc1(CNIL,LEA,(REX_W << 16) | modregxrm(0,r1,5),FLswitch,0);        // LEA R1,disp[RIP]
+            gen2sib(ce,0x63,(REX_W << 16) | modregxrm(0,r2,4), modregxrmx(2,reg,r1)); // MOVSXD R2,[reg*4][R1]
+            gen2sib(ce,LEA,(REX_W << 16) | modregxrm(0,r1,4),modregxrmx(0,r1,r2));    // LEA R1,[R1][R2]
+            gen2(ce,0xFF,modregrmx(3,4,r1));                                          // JMP R1
+        }
+        else
+        {
+            ce = genc1(CNIL,0xFF,modregrm(0,4,4),FLswitch,0);   // JMP disp[reg*8]
+            ce->Isib = modregrm(3,reg & 7,5);
+            if (reg & 8)
+                ce->Irex |= REX_X;
+        }
+    }
+    else if (I32)
+    {
+#if TARGET_OSX
+        /*     CALL L1
+         * L1: POP  R1
+         *     ADD  R1,disp[reg*4][R1]
+         *     JMP  R1
+         */
+        // Allocate scratch register r1
+        regm_t scratchm = ALLREGS & ~mask[reg];
+        unsigned r1;
+        c = cat(c, allocreg(&scratchm,&r1,TYint));
+
+        c = genc2(c,CALL,0,0);                               //     CALL L1
+        gen1(c, 0x58 + r1);                                  // L1: POP R1
+        ce = genc1(CNIL,0x03,modregrm(2,r1,4),FLswitch,0);   // ADD R1,disp[reg*4][EBX]
+        ce->Isib = modregrm(2,reg,r1);
+        gen2(ce,0xFF,modregrm(3,4,r1));                      // JMP R1
+#else
+        if (config.flags3 & CFG3pic)
+        {
+            /* MOV  R1,EBX
+             * SUB  R1,funcsym_p@GOTOFF[offset][reg*4][EBX]
+             * JMP  R1
+             */
+
+            // Load GOT in EBX
+            c = cat(c,load_localgot());
+
+            // Allocate scratch register r1
+            regm_t scratchm = ALLREGS & ~(mask[reg] | mBX);
+            unsigned r1;
+            c = cat(c, allocreg(&scratchm,&r1,TYint));
+
+            c = genmovreg(c,r1,BX);                                 // MOV R1,EBX
+            ce = genc1(CNIL,0x2B,modregxrm(2,r1,4),FLswitch,0);     // SUB R1,disp[reg*4][EBX]
+            ce->Isib = modregrm(2,reg,BX);
+            gen2(ce,0xFF,modregrmx(3,4,r1));                        // JMP R1
+        }
+        else
+        {
+            ce = genc1(CNIL,0xFF,modregrm(0,4,4),FLswitch,0);       // JMP disp[idxreg*4]
+            ce->Isib = modregrm(2,reg,5);
+        }
+#endif
+    }
+    else
+        assert(0);
+    ce->IEV1.Vswitch = b;
+    return cat(c,ce);
+}
+
+/*******************************
+ * Generate a binary search over clusters[0..nclusters]. A single
+ * case is compared for directly, a jump table slice is range checked
+ * and then dispatched through the jump table.
+ */
+
+static code *clustertree(block *b, SwitchCluster *clusters, size_t nclusters,
+        unsigned sz, unsigned reg, unsigned reg2, unsigned sreg, block *bdefault, bool last)
+{
+    size_t pivot = nclusters >> 1;
+    SwitchCluster *cl = &clusters[pivot];
+    code *c1 = CNIL;
+    code *c2 = CNIL;
+    if (nclusters > 1)
+    {
+        // Compares for clusters[0..pivot]
+        c1 = clustertree(b, clusters, pivot, sz, reg, reg2, sreg, bdefault, true);
+
+        // Compares for clusters[pivot+1..nclusters]
+        if (pivot + 1 < nclusters)
+            c2 = clustertree(b, cl + 1, nclusters - pivot - 1, sz, reg, reg2, sreg, bdefault, last);
+    }
+
+    // Note unsigned jumps here, as cases were sorted using unsigned comparisons
+    code *c;
+    if (cl->jmptab)
+    {
+        assert(reg2 == NOREG && sz <= 4);
+        targ_llong lo = cl->cases[0].val;
+        targ_llong hi = cl->cases[cl->ncases - 1].val;
+
+        c = cmpval(lo, sz, reg, reg2, sreg);                    // CMP reg,lo
+        if (c1)
+            genjmp(c,JB,FLcode,(block *) c1);                   // JB c1
+        else
+            genjmp(c,JB,FLblock,bdefault);                      // JB default
+        c = cat(c, cmpval(hi, sz, reg, reg2, sreg));            // CMP reg,hi
+        if (c2)
+            genjmp(c,JA,FLcode,(block *) c2);                   // JA c2
+        else
+            genjmp(c,JA,FLblock,bdefault);                      // JA default
+
+        targ_ulong bias = lo - cl->index;
+        if (bias)
+            c = genc2(c,0x81,modregrmx(3,5,reg),bias);          // SUB reg,lo-index
+        else if (I64)
+        {   // Need to clear out high 32 bits of reg
+            c = genmovreg(c,reg,reg);                           // MOV reg,reg
+        }
+        c = cat(c, jmptabjump(b, reg));
+    }
+    else
+    {
+        c = cmpval(cl->cases[0].val, sz, reg, reg2, sreg);
+        genjmp(c,JE,FLblock,cl->cases[0].target);               // JE target
+        if (c2)
+            genjmp(c,JA,FLcode,(block *) c2);                   // JA c2
+        else if (c1)
+            genjmp(c,JA,FLblock,bdefault);                      // JA default
+        else if (last)  // if default is not next block
+            genjmp(c,JMP,FLblock,bdefault);                     // JMP default
+    }
+    return cat3(c,c1,c2);
+}
+
 /*******************************
  * Generate code for blocks ending in a switch statement.
  * Take BCswitch and decide on
  *      BCifthen        use if - then code
- *      BCjmptab        index into jump table
+ *      BCjmptab        index into jump table, possibly after a binary
+ *                      search for which slice of the table to use
  *      BCswitch        search table for match
  */
 
@@ -1282,11 +1538,51 @@ void doswitch(block *b)
         goto Lifthen;
 
     /*************************************************************************/
-    {   // generate if-then sequence
+    {   // generate if-then sequence, or a binary search over clusters of cases
     Lifthen:
+        // Sort cases so we can do a runtime binary search
+        CaseVal *casevals = sortcases(b, p, ncases);
+
+        //for (unsigned n = 0; n < ncases; n++)
+            //printf("casevals[%lld] = x%x\n", n, casevals[n].val);
+
+        /* Dense runs of cases can each get a slice of the jump table,
+         * as long as the switch value fits in an index register and
+         * the table entries don't depend on where the jump is.
+         */
+        SwitchCluster *clusters = NULL;
+        size_t nclusters = 0;
+        targ_size_t entries = 0;
+        if (ncases > 3 && !I16)
+        {
+            bool tables = !dword && sz <= 4;
+#if JMPJMPTABLE || TARGET_OSX
+            if (I32)
+                tables = false;         // table is relative to the jump
+#endif
+            clusters = (SwitchCluster *)malloc(ncases * sizeof(SwitchCluster));
+            assert(clusters);
+            nclusters = switchclusters(casevals, ncases, tables, clusters, &entries);
+        }
+
         regm_t retregs = ALLREGS;
         b->BC = BCifthen;
-        c = scodelem(e,&retregs,0,TRUE);
+        if (entries)
+        {
+            b->BC = BCjmptab;
+            b->Btablesize = entries * jmptabentsize();
+            retregs = IDXREGS;
+#if TARGET_LINUX || TARGET_FREEBSD || TARGET_OPENBSD || TARGET_SOLARIS
+            if (I32 && config.flags3 & CFG3pic)
+                retregs &= ~mBX;                        // need EBX for GOT
+#endif
+        }
+        c = scodelem(e,&retregs,0,!entries);
+        if (entries)
+        {
+            assert(!(retregs & regcon.mvar));
+            c = cat(c,getregs(retregs));
+        }
         unsigned reg, reg2;
         if (dword)
         {   reg = findreglsw(retregs);
@@ -1307,16 +1603,8 @@ void doswitch(block *b)
         }
 
         unsigned sreg = NOREG;                          // may need a scratch register
-
-        // Put into casevals[0..ncases] so we can sort then slice
-        CaseVal *casevals = (CaseVal *)malloc(ncases * sizeof(CaseVal));
-        assert(casevals);
         for (unsigned n = 0; n < ncases; n++)
         {
-            casevals[n].val = p[n];
-            bl = list_next(bl);
-            casevals[n].target = list_block(bl);
-
             // See if we need a scratch register
             if (sreg == NOREG && I64 && sz == 8 && p[n] != (int)p[n])
             {   regm_t regm = ALLREGS & ~mask[reg];
@@ -1324,15 +1612,13 @@ void doswitch(block *b)
             }
         }
 
-        // Sort cases so we can do a runtime binary search
-        qsort(casevals, ncases, sizeof(CaseVal), &CaseVal::cmp);
-
-        //for (unsigned n = 0; n < ncases; n++)
-            //printf("casevals[%lld] = x%x\n", n, casevals[n].val);
-
         // Generate binary tree of comparisons
-        c = cat(c, ifthen(casevals, ncases, sz, reg, reg2, sreg, bdefault, bdefault != b->Bnext));
+        if (clusters)
+            c = cat(c, clustertree(b, clusters, nclusters, sz, reg, reg2, sreg, bdefault, bdefault != b->Bnext));
+        else
+            c = cat(c, ifthen(casevals, ncases, sz, reg, reg2, sreg, bdefault, bdefault != b->Bnext));
 
+        free(clusters);
         free(casevals);
 
         ce = NULL;
@@ -1355,7 +1641,7 @@ void doswitch(block *b)
         if (vmin > 0 && vmin <= intsize)
             vmin = 0;
 
-        b->Btablesize = (int) (vmax - vmin + 1) * tysize[TYnptr];
+        b->Btablesize = (int) (vmax - vmin + 1) * jmptabentsize();
         regm_t retregs = IDXREGS;
         if (dword)
             retregs |= mMSW;
@@ -1397,34 +1683,7 @@ void doswitch(block *b)
             {   // Need to clear out high 32 bits of reg
                 c = genmovreg(c,reg,reg);                       // MOV reg,reg
             }
-            if (config.flags3 & CFG3pic || config.exe == EX_WIN64)
-            {
-                /* LEA    R1,disp[RIP]          48 8D 05 00 00 00 00
-                 * MOVSXD R2,[reg*4][R1]        48 63 14 B8
-                 * LEA    R1,[R1][R2]           48 8D 04 02
-                 * JMP    R1                    FF E0
-                 */
-                unsigned r1;
-                regm_t scratchm = ALLREGS & ~mask[reg];
-                c = cat(c, allocreg(&scratchm,&r1,TYint));
-                unsigned r2;
-                scratchm = ALLREGS & ~(mask[reg] | mask[r1]);
-                c = cat(c, allocreg(&scratchm,&r2,TYint));
-
-                ce = genc1(CNIL,LEA,(REX_W << 16) | modregxrm(0,r1,5),FLswitch,0);        // LEA R1,disp[RIP]
-                gen2sib(ce,0x63,(REX_W << 16) | modregxrm(0,r2,4), modregxrmx(2,reg,r1)); // MOVSXD R2,[reg*4][R1]
-                gen2sib(ce,LEA,(REX_W << 16) | modregxrm(0,r1,4),modregxrmx(0,r1,r2));    // LEA R1,[R1][R2]
-                gen2(ce,0xFF,modregrmx(3,4,r1));                                          // JMP R1
-
-                b->Btablesize = (int) (vmax - vmin + 1) * 4;
-            }
-            else
-            {
-                ce = genc1(CNIL,0xFF,modregrm(0,4,4),FLswitch,0);   // JMP disp[reg*8]
-                ce->Isib = modregrm(3,reg & 7,5);
-                if (reg & 8)
-                    ce->Irex |= REX_X;
-            }
+            ce = jmptabjump(b,reg);
         }
         else if (I32)
         {
@@ -1467,48 +1726,8 @@ void doswitch(block *b)
             ce = cat(ce, ctable);
             b->Btablesize = 0;
             goto L2;
-#elif TARGET_OSX
-            /*     CALL L1
-             * L1: POP  R1
-             *     ADD  R1,disp[reg*4][R1]
-             *     JMP  R1
-             */
-            // Allocate scratch register r1
-            regm_t scratchm = ALLREGS & ~mask[reg];
-            unsigned r1;
-            c = cat(c, allocreg(&scratchm,&r1,TYint));
-
-            c = genc2(c,CALL,0,0);                               //     CALL L1
-            gen1(c, 0x58 + r1);                                  // L1: POP R1
-            ce = genc1(CNIL,0x03,modregrm(2,r1,4),FLswitch,0);   // ADD R1,disp[reg*4][EBX]
-            ce->Isib = modregrm(2,reg,r1);
-            gen2(ce,0xFF,modregrm(3,4,r1));                      // JMP R1
 #else
-            if (config.flags3 & CFG3pic)
-            {
-                /* MOV  R1,EBX
-                 * SUB  R1,funcsym_p@GOTOFF[offset][reg*4][EBX]
-                 * JMP  R1
-                 */
-
-                // Load GOT in EBX
-                c = cat(c,load_localgot());
-
-                // Allocate scratch register r1
-                regm_t scratchm = ALLREGS & ~(mask[reg] | mBX);
-                unsigned r1;
-                c = cat(c, allocreg(&scratchm,&r1,TYint));
-
-                c = genmovreg(c,r1,BX);                                 // MOV R1,EBX
-                ce = genc1(CNIL,0x2B,modregxrm(2,r1,4),FLswitch,0);     // SUB R1,disp[reg*4][EBX]
-                ce->Isib = modregrm(2,reg,BX);
-                gen2(ce,0xFF,modregrmx(3,4,r1));                        // JMP R1
-            }
-            else
-            {
-                ce = genc1(CNIL,0xFF,modregrm(0,4,4),FLswitch,0);       // JMP disp[idxreg*4]
-                ce->Isib = modregrm(2,reg,5);
-            }
+            ce = jmptabjump(b,reg);
 #endif
         }
         else if (I16)
@@ -1517,10 +1736,10 @@ void doswitch(block *b)
             unsigned rm = getaddrmode(retregs) | modregrm(0,4,0);
             ce = genc1(CNIL,0xFF,rm,FLswitch,0);                  // JMP [CS:]disp[idxreg]
             ce->Iflags |= csseg ? CFcs : 0;                       // segment override
+            ce->IEV1.Vswitch = b;
         }
         else
             assert(0);
-        ce->IEV1.Vswitch = b;
         goto L2;
     }
 
@@ -1652,6 +1871,65 @@ L2: ;
     cgstate.stackclean--;
 }
 
+/******************************
+ * Output entry number index of the jump table of b,
+ * which jumps to targ.
+ */
+
+static void outjmptabent(block *b, int jmpseg, targ_size_t *poffset,
+        targ_size_t targ, targ_size_t index, symbol **pgotsym)
+{
+#if TARGET_LINUX || TARGET_FREEBSD || TARGET_OPENBSD || TARGET_SOLARIS
+    if (I64)
+    {
+        if (config.flags3 & CFG3pic)
+        {
+            objmod->reftodatseg(jmpseg,*poffset,targ + index * 4,funcsym_p->Sseg,CFswitch);
+            *poffset += 4;
+        }
+        else
+        {
+            objmod->reftodatseg(jmpseg,*poffset,targ,funcsym_p->Sxtrnnum,CFoffset64 | CFswitch);
+            *poffset += 8;
+        }
+    }
+    else
+    {
+        if (config.flags3 & CFG3pic)
+        {
+            assert(config.flags & CFGromable);
+            // Want a GOTPC fixup to _GLOBAL_OFFSET_TABLE_
+            if (!*pgotsym)
+                *pgotsym = Obj::getGOTsym();
+            objmod->reftoident(jmpseg,*poffset,*pgotsym,*poffset - targ,CFswitch);
+        }
+        else
+            objmod->reftocodeseg(jmpseg,*poffset,targ);
+        *poffset += 4;
+    }
+#elif TARGET_OSX
+    targ_size_t val;
+    if (I64)
+        val = targ - b->Btableoffset;
+    else
+        val = targ - b->Btablebase;
+    objmod->write_bytes(SegData[jmpseg],4,&val);
+#elif TARGET_WINDOS
+    if (I64)
+    {
+        targ_size_t val = targ - b->Btableoffset;
+        objmod->write_bytes(SegData[jmpseg],4,&val);
+    }
+    else
+    {
+        objmod->reftocodeseg(jmpseg,*poffset,targ);
+        *poffset += tysize[TYnptr];
+    }
+#else
+    assert(0);
+#endif
+}
+
 /******************************
  * Output data block for a jump table (BCjmptab).
  * The 'holes' in the table get filled with the
@@ -1677,6 +1955,7 @@ void outjmptab(block *b)
         if (val > vmax) vmax = val;
         if (val < vmin) vmin = val;
     }
+    bool sparse = (targ_ullong)(vmax - vmin) > ncases * 3;
     if (vmin > 0 && vmin <= intsize)
         vmin = 0;
     assert(vmin <= vmax);
@@ -1694,6 +1973,41 @@ void outjmptab(block *b)
 
     symbol *gotsym = NULL;
     targ_size_t def = list_block(b->Bsucc)->Boffset;  // default address
+    if (sparse)
+    {
+        /* Slices of the table for the clusters of cases,
+         * one after the other.
+         */
+        CaseVal *casevals = sortcases(b, p, ncases);
+        SwitchCluster *clusters = (SwitchCluster *)malloc(ncases * sizeof(SwitchCluster));
+        assert(clusters);
+        targ_size_t entries;
+        size_t nclusters = switchclusters(casevals, ncases, true, clusters, &entries);
+        targ_size_t index = 0;
+        for (size_t i = 0; i < nclusters; i++)
+        {
+            SwitchCluster *cl = &clusters[i];
+            if (!cl->jmptab)
+                continue;
+            assert(cl->index == index);
+            CaseVal *cv = cl->cases;
+            for (targ_ullong u = cv[0].val; ; u++)
+            {   targ_size_t targ = def;
+                if (cv->val == u)
+                {   targ = cv->target->Boffset;
+                    cv++;
+                }
+                outjmptabent(b,jmpseg,poffset,targ,index++,&gotsym);
+                if (cv == cl->cases + cl->ncases)
+                    break;
+            }
+        }
+        assert(index == entries);
+        free(clusters);
+        free(casevals);
+        return;
+    }
+
     for (targ_llong u = vmin; ; u++)
     {   targ_size_t targ = def;                     // default
         for (size_t n = 0; n < ncases; n++)
@@ -1702,61 +2016,12 @@ void outjmptab(block *b)
                         break;
                 }
         }
-#if TARGET_LINUX || TARGET_FREEBSD || TARGET_OPENBSD || TARGET_SOLARIS
-        if (I64)
-        {
-            if (config.flags3 & CFG3pic)
-            {
-                objmod->reftodatseg(jmpseg,*poffset,targ + (u - vmin) * 4,funcsym_p->Sseg,CFswitch);
-                *poffset += 4;
-            }
-            else
-            {
-                objmod->reftodatseg(jmpseg,*poffset,targ,funcsym_p->Sxtrnnum,CFoffset64 | CFswitch);
-                *poffset += 8;
-            }
-        }
-        else
-        {
-            if (config.flags3 & CFG3pic)
-            {
-                assert(config.flags & CFGromable);
-                // Want a GOTPC fixup to _GLOBAL_OFFSET_TABLE_
-                if (!gotsym)
-                    gotsym = Obj::getGOTsym();
-                objmod->reftoident(jmpseg,*poffset,gotsym,*poffset - targ,CFswitch);
-            }
-            else
-                objmod->reftocodeseg(jmpseg,*poffset,targ);
-            *poffset += 4;
-        }
-#elif TARGET_OSX
-        targ_size_t val;
-        if (I64)
-            val = targ - b->Btableoffset;
-        else
-            val = targ - b->Btablebase;
-        objmod->write_bytes(SegData[jmpseg],4,&val);
-#elif TARGET_WINDOS
-        if (I64)
-        {
-            targ_size_t val = targ - b->Btableoffset;
-            objmod->write_bytes(SegData[jmpseg],4,&val);
-        }
-        else
-        {
-            objmod->reftocodeseg(jmpseg,*poffset,targ);
-            *poffset += tysize[TYnptr];
-        }
-#else
-        assert(0);
-#endif
+        outjmptabent(b,jmpseg,poffset,targ,u - vmin,&gotsym);
         if (u == vmax)                  // for case that (vmax == ~0)
             break;
     }
 }
 
-
 /******************************
  * Output data block for a switch table.
  * Two consecutive tables, the first is the case value table, the
@@ -55,10 +55,7 @@ static elem *nextfree = NULL;           /* pointer to next free elem    */
 
 static int elcount = 0;                 /* number of allocated elems    */
 static int elem_size = sizeof(elem);
-
-#ifdef DEBUG
 static int elmax;                       /* max # of allocs at any point */
-#endif
 
 /////////////////////////////
 // Table to gather redundant strings in.
@@ -119,6 +116,18 @@ void el_term()
 #endif
 }
 
+/***********************
+ * Report how many elems are allocated now, the most there have been,
+ * and the size of each.
+ */
+
+void el_stats(unsigned *count, unsigned *peak, size_t *size)
+{
+    *count = elcount;
+    *peak = elmax;
+    *size = elem_size;
+}
+
 /***********************
  * Allocate an element.
  */
@@ -139,10 +148,10 @@ elem *el_calloc()
 #endif
     MEMCLEAR(e, sizeof(*e));
 
-#ifdef DEBUG
-    e->id = IDelem;
     if (elcount > elmax)
         elmax = elcount;
+#ifdef DEBUG
+    e->id = IDelem;
 #endif
     /*dbg_printf("el_calloc() = %p\n",e);*/
     return e;
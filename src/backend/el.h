@@ -124,6 +124,7 @@ void el_reset(void);
 void el_term(void);
 elem_p el_calloc(void);
 void el_free(elem_p);
+void el_stats(unsigned *count, unsigned *peak, size_t *size);
 elem_p el_combine(elem_p ,elem_p);
 elem_p el_param(elem_p ,elem_p);
 elem_p el_params(elem_p , ...);
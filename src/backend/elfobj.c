@@ -202,6 +202,7 @@ void TypeInfo_Idxstr::swap(void *p1, void *p2)
 
 // String Table  - String table for all other names
 static Outbuffer *symtab_strings;
+static Strtab symtab_index;     // index of the strings in symtab_strings
 
 
 // Section Headers
@@ -324,57 +325,38 @@ IDXSTR Obj::addstr(Outbuffer *strtab, const char *str)
 }
 
 /*******************************
- * Find a string in a string table
- * Input:
- *      strtab  =       string table for entry
- *      str     =       string to find
- *
- * Returns index into the specified string table or 0.
+ * Output a string into the symbol string table,
+ * unless it is already there.
+ * Returns index into the table.
  */
 
-static IDXSTR elf_findstr(Outbuffer *strtab, const char *str, const char *suffix)
+static IDXSTR elf_addsymstr(const char *str)
 {
-    //printf("elf_findstr(strtab = %p, str = %s, suffix = %s\n", strtab, str ? str : "", suffix ? suffix : "");
+    return symtab_index.add(str);
+}
 
-    size_t len = strlen(str);
+/*******************************
+ * Share the tails of the strings in the symbol string table,
+ * and point the symbol names at their new locations.
+ * Input:
+ *      symtab  =       symbol table from elf_renumbersyms()
+ */
 
-    // Combine str~suffix and have buf point to the combination
-#ifdef DEBUG
-    char tmpbuf[25];    // to exercise the alloca() code path
-#else
-    char tmpbuf[1024];  // the alloca() code path is slow
-#endif
-    const char *buf;
-    if (suffix)
+static void elf_tailmerge(void *symtab)
+{
+    symtab_index.tailmerge();
+    if (I64)
     {
-        size_t suffixlen = strlen(suffix);
-        if (len + suffixlen >= sizeof(tmpbuf))
-        {
-             buf = (char *)alloca(len + suffixlen + 1);
-             assert(buf);
-        }
-        else
-        {
-             buf = tmpbuf;
-        }
-        memcpy((char *)buf, str, len);
-        memcpy((char *)buf + len, suffix, suffixlen + 1);
-        len += suffixlen;
+        Elf64_Sym *s = (Elf64_Sym *)symtab;
+        for (int i = 0; i < symbol_idx; i++)
+            s[i].st_name = symtab_index.remap(s[i].st_name);
     }
     else
-        buf = str;
-
-    // Linear search, slow
-    const char *ent = (char *)strtab->buf+1;
-    const char *pend = ent+strtab->size() - 1;
-    while (ent + len < pend)
     {
-        if (memcmp(buf, ent, len + 1) == 0)
-            return ent - (const char *)strtab->buf;
-        ent = (const char *)memchr(ent, 0, pend - ent);
-        ent += 1;
+        Elf32_Sym *s = (Elf32_Sym *)symtab;
+        for (int i = 0; i < symbol_idx; i++)
+            s[i].st_name = symtab_index.remap(s[i].st_name);
     }
-    return 0;                   // never found match
 }
 
 /*******************************
@@ -391,10 +373,8 @@ static IDXSTR elf_addmangled(Symbol *s)
     char dest[DEST_LEN];
     char *destr;
     const char *name;
-    int len;
     IDXSTR namidx;
 
-    namidx = symtab_strings->size();
     destr = obj_mangle2(s, dest);
     name = destr;
     if (CPP && name[0] == '_' && name[1] == '_')
@@ -428,13 +408,10 @@ static IDXSTR elf_addmangled(Symbol *s)
     }
     else if (tyfunc(s->ty()) && s->Sfunc && s->Sfunc->Fredirect)
         name = s->Sfunc->Fredirect;
-    len = strlen(name);
-    symtab_strings->reserve(len+1);
-    strcpy((char *)symtab_strings->p,name);
-    symtab_strings->setsize(namidx+len+1);
+    namidx = elf_addsymstr(name);
     if (destr != dest)                  // if we resized result
         mem_free(destr);
-    //dbg_printf("\telf_addmagled symtab_strings %s namidx %d len %d size %d\n",name, namidx,len,symtab_strings->size());
+    //dbg_printf("\telf_addmagled symtab_strings %s namidx %d size %d\n",name, namidx,symtab_strings->size());
     return namidx;
 }
 
@@ -688,6 +665,7 @@ Obj *Obj::init(Outbuffer *objbuf, const char *filename, const char *csegname)
         symtab_strings->reserve(2048);
         symtab_strings->writeByte(0);
     }
+    symtab_index.reset(symtab_strings);
 
     if (SECbuf)
         SECbuf->setsize(0);
@@ -854,7 +832,7 @@ void Obj::initfile(const char *filename, const char *csegname, const char *modna
 {
     //dbg_printf("Obj::initfile(filename = %s, modname = %s)\n",filename,modname);
 
-    IDXSTR name = Obj::addstr(symtab_strings, filename);
+    IDXSTR name = elf_addsymstr(filename);
     if (I64)
         SymbolTable64[STI_FILE].st_name = name;
     else
@@ -863,9 +841,9 @@ void Obj::initfile(const char *filename, const char *csegname, const char *modna
 #if 0
     // compiler flag for linker
     if (I64)
-        SymbolTable64[STI_GCC].st_name = Obj::addstr(symtab_strings,"gcc2_compiled.");
+        SymbolTable64[STI_GCC].st_name = elf_addsymstr("gcc2_compiled.");
     else
-        SymbolTable[STI_GCC].st_name = Obj::addstr(symtab_strings,"gcc2_compiled.");
+        SymbolTable[STI_GCC].st_name = elf_addsymstr("gcc2_compiled.");
 #endif
 
     if (csegname && *csegname && strcmp(csegname,".text"))
@@ -1087,6 +1065,7 @@ void Obj::term(const char *objfilename)
     Elf32_Shdr *sechdr;
     seg_data *seg;
     void *symtab = elf_renumbersyms();
+    elf_tailmerge(symtab);
     FILE *fd = NULL;
 
     // Output the ELF Header
@@ -1496,7 +1475,7 @@ void Obj::wkext(Symbol *s1,Symbol *s2)
 void obj_filename(const char *modname)
 {
     //dbg_printf("obj_filename(char *%s)\n",modname);
-    unsigned strtab_idx = Obj::addstr(symtab_strings,modname);
+    unsigned strtab_idx = elf_addsymstr(modname);
     elf_addsym(strtab_idx,0,0,STT_FILE,STB_LOCAL,SHN_ABS);
 }
 
@@ -1611,14 +1590,14 @@ void Obj::ehsections()
     int sec = ElfObj::getsegment(".deh_beg", NULL, SHT_PROGDEF, SHF_ALLOC, NPTRSIZE);
     //Obj::bytes(sec, 0, 4, NULL);
 
-    IDXSTR namidx = Obj::addstr(symtab_strings,"_deh_beg");
+    IDXSTR namidx = elf_addsymstr("_deh_beg");
     elf_addsym(namidx, 0, 4, STT_OBJECT, STB_GLOBAL, MAP_SEG2SECIDX(sec));
     //elf_addsym(namidx, 0, 4, STT_OBJECT, STB_GLOBAL, MAP_SEG2SECIDX(sec));
 
     ElfObj::getsegment(".deh_eh", NULL, SHT_PROGDEF, SHF_ALLOC, NPTRSIZE);
 
     sec = ElfObj::getsegment(".deh_end", NULL, SHT_PROGDEF, SHF_ALLOC, NPTRSIZE);
-    namidx = Obj::addstr(symtab_strings,"_deh_end");
+    namidx = elf_addsymstr("_deh_end");
     elf_addsym(namidx, 0, 4, STT_OBJECT, STB_GLOBAL, MAP_SEG2SECIDX(sec));
 
     obj_tlssections();
@@ -1636,13 +1615,13 @@ void obj_tlssections()
     int sec = ElfObj::getsegment(".tdata", NULL, SHT_PROGDEF, SHF_ALLOC|SHF_WRITE|SHF_TLS, align);
     Obj::bytes(sec, 0, align, NULL);
 
-    namidx = Obj::addstr(symtab_strings,"_tlsstart");
+    namidx = elf_addsymstr("_tlsstart");
     elf_addsym(namidx, 0, align, STT_TLS, STB_GLOBAL, MAP_SEG2SECIDX(sec));
 
     ElfObj::getsegment(".tdata.", NULL, SHT_PROGDEF, SHF_ALLOC|SHF_WRITE|SHF_TLS, align);
 
     sec = ElfObj::getsegment(".tcommon", NULL, SHT_NOBITS, SHF_ALLOC|SHF_WRITE|SHF_TLS, align);
-    namidx = Obj::addstr(symtab_strings,"_tlsend");
+    namidx = elf_addsymstr("_tlsend");
     elf_addsym(namidx, 0, align, STT_TLS, STB_GLOBAL, MAP_SEG2SECIDX(sec));
 }
 
@@ -2210,7 +2189,7 @@ int Obj::external_def(const char *name)
 {
     //dbg_printf("Obj::external_def('%s')\n",name);
     assert(name);
-    IDXSTR namidx = Obj::addstr(symtab_strings,name);
+    IDXSTR namidx = elf_addsymstr(name);
     IDXSYM symidx = elf_addsym(namidx, 0, 0, STT_NOTYPE, STB_GLOBAL, SHN_UNDEF);
     return symidx;
 }
@@ -3248,7 +3227,7 @@ static void obj_rtinit()
 
 #if DEBUG
             // adds a local symbol (name) to the code, useful to set a breakpoint
-            namidx = ElfObj::addstr(symtab_strings, "__d_dso_init");
+            namidx = elf_addsymstr("__d_dso_init");
             elf_addsym(namidx, 0, 0, STT_FUNC, STB_LOCAL, MAP_SEG2SECIDX(codseg));
 #endif
         }
@@ -3347,7 +3326,7 @@ static void obj_rtinit()
 #else
 
         // use a weak reference for _d_dso_registry
-        namidx = ElfObj::addstr(symtab_strings, "_d_dso_registry");
+        namidx = elf_addsymstr("_d_dso_registry");
         const IDXSYM symidx = elf_addsym(namidx, 0, 0, STT_NOTYPE, STB_WEAK, SHN_UNDEF);
 
         if (config.flags3 & CFG3pic)
@@ -54,6 +54,44 @@ STATIC void accumlv(vec_t GEN , vec_t KILL , elem *n);
 STATIC void accumvbe(vec_t GEN , vec_t KILL , elem *n);
 STATIC void accumrd(vec_t GEN , vec_t KILL , elem *n);
 STATIC void flowaecp(void);
+STATIC vec_t worklist(unsigned first);
+STATIC void addwork(vec_t work, list_t bl);
+
+FlowStats rdstats, aestats, cpstats, lvstats, vbestats;
+
+/***************************
+ * Create a worklist of the blocks whose flow sets need to be
+ * (re)computed, indexed by position in dfo[]. The analyses make
+ * passes over dfo[] recomputing only the blocks on the worklist,
+ * until it is empty. A block whose result changed puts the blocks
+ * that depend on it back on the worklist.
+ * Input:
+ *      first   dfo[first .. dfotop] start on the worklist
+ */
+
+STATIC vec_t worklist(unsigned first)
+{
+        vec_t work = vec_calloc(dfotop);
+        for (unsigned i = first; i < dfotop; i++)
+                vec_setbit(i,work);
+        return work;
+}
+
+/***************************
+ * Put the blocks in list bl on worklist work.
+ */
+
+STATIC void addwork(vec_t work, list_t bl)
+{
+        for (; bl; bl = list_next(bl))
+        {       block *b = list_block(bl);
+                unsigned i = b->Bdfoidx;
+
+                // Unreachable blocks are not in dfo[]
+                if (i < dfotop && dfo[i] == b)
+                        vec_setbit(i,work);
+        }
+}
 
 /***************** REACHING DEFINITIONS *********************/
 
@@ -71,7 +109,7 @@ STATIC void flowaecp(void);
 void flowrd()
 {       register vec_t tmp;
         register unsigned i;
-        register bool anychng;
+        vec_t work;
 
         rdgenkill();            /* Compute Bgen and Bkill for RDs       */
         if (deftop == 0)        /* if no definition elems               */
@@ -86,12 +124,17 @@ void flowrd()
                 vec_copy(dfo[i]->Boutrd,dfo[i]->Bgen);
 
         tmp = vec_calloc(deftop);
+        work = worklist(0);
         do
-        {       anychng = FALSE;
+        {       rdstats.passes++;
                 for (i = 0; i < dfotop; i++)    /* for each block       */
                 {       register block *b;
                         register list_t bp;
 
+                        if (!vec_testbit(i,work))
+                                continue;
+                        vec_clearbit(i,work);
+                        rdstats.blocks++;
                         b = dfo[i];
 
                         /* Binrd = union of Boutrds of all predecessors of b */
@@ -108,11 +151,13 @@ void flowrd()
                         /* Bout = (Bin - Bkill) | Bgen */
                         vec_sub(tmp,b->Binrd,b->Bkill);
                         vec_orass(tmp,b->Bgen);
-                        if (!anychng)
-                                anychng = !vec_equal(tmp,b->Boutrd);
-                        vec_copy(b->Boutrd,tmp);
+                        if (!vec_equal(tmp,b->Boutrd))
+                        {       vec_copy(b->Boutrd,tmp);
+                                addwork(work,b->Bsucc);
+                        }
                 }
-        } while (anychng);              /* while any changes to Boutrd  */
+        } while (vec_index(0,work) < dfotop); /* while any changes to Boutrd */
+        vec_free(work);
         vec_free(tmp);
 
 #if 0
@@ -350,7 +395,8 @@ void flowcp()
 STATIC void flowaecp()
 {       vec_t tmp;
         register unsigned i;
-        bool anychng;
+        vec_t work;
+        FlowStats *stats = (flowxx == AE) ? &aestats : &cpstats;
 
         aecpgenkill();          /* Compute Bgen and Bkill for AEs or CPs */
         if (exptop <= 1)        /* if no expressions                    */
@@ -382,14 +428,21 @@ STATIC void flowaecp()
         }
 
         tmp = vec_calloc(exptop);
+        work = worklist(1);
         do
-        {   anychng = FALSE;
+        {   stats->passes++;
 
             // For all blocks except startblock
             for (i = 1; i < dfotop; i++)
             {   block *b = dfo[i];
                 list_t bl = b->Bpred;
                 block *bp;
+                bool changed = FALSE;
+
+                if (!vec_testbit(i,work))
+                    continue;
+                vec_clearbit(i,work);
+                stats->blocks++;
 
                 // Bin = & of Bout of all predecessors
                 // Bout = (Bin - Bkill) | Bgen
@@ -411,51 +464,43 @@ STATIC void flowaecp()
                         vec_andass(b->Bin,bp->Bout);
                 }
 
-                if (anychng)
-                {   vec_sub(b->Bout,b->Bin,b->Bkill);
-                    vec_orass(b->Bout,b->Bgen);
+                vec_sub(tmp,b->Bin,b->Bkill);
+                vec_orass(tmp,b->Bgen);
+                if (!vec_equal(tmp,b->Bout))
+                {   // Swap Bout and tmp instead of
+                    // copying tmp over Bout
+                    vec_t v;
+
+                    v = tmp;
+                    tmp = b->Bout;
+                    b->Bout = v;
+                    changed = TRUE;
                 }
-                else
-                {   vec_sub(tmp,b->Bin,b->Bkill);
-                    vec_orass(tmp,b->Bgen);
-                    if (!vec_equal(tmp,b->Bout))
+
+                if (b->BC == BCiftrue)
+                {   // Bout2 = (Bin - Bkill2) | Bgen2
+                    vec_sub(tmp,b->Bin,b->Bkill2);
+                    vec_orass(tmp,b->Bgen2);
+                    if (!vec_equal(tmp,b->Bout2))
                     {   // Swap Bout and tmp instead of
-                        // copying tmp over Bout
+                        // copying tmp over Bout2
                         vec_t v;
 
                         v = tmp;
-                        tmp = b->Bout;
-                        b->Bout = v;
-                        anychng = TRUE;
+                        tmp = b->Bout2;
+                        b->Bout2 = v;
+                        changed = TRUE;
                     }
                 }
 
-                if (b->BC == BCiftrue)
-                {   // Bout2 = (Bin - Bkill2) | Bgen2
-                    if (anychng)
-                    {   vec_sub(b->Bout2,b->Bin,b->Bkill2);
-                        vec_orass(b->Bout2,b->Bgen2);
-                    }
-                    else
-                    {   vec_sub(tmp,b->Bin,b->Bkill2);
-                        vec_orass(tmp,b->Bgen2);
-                        if (!vec_equal(tmp,b->Bout2))
-                        {   // Swap Bout and tmp instead of
-                            // copying tmp over Bout2
-                            vec_t v;
-
-                            v = tmp;
-                            tmp = b->Bout2;
-                            b->Bout2 = v;
-                            anychng = TRUE;
-                        }
-                    }
-                }
+                if (changed)
+                    addwork(work,b->Bsucc);
             }
-        } while (anychng);
+        } while (vec_index(0,work) < dfotop);
+        vec_free(work);
         vec_free(tmp);
 }
-
+
 /******************************
  * A variable to avoid parameter overhead to asgexpelems().
  */
@@ -1137,7 +1182,7 @@ STATIC void accumaecpx(elem *n)
 void flowlv()
 {       vec_t tmp,livexit;
         register unsigned i;
-        bool anychng;
+        vec_t work;
         unsigned cnt;
 
         lvgenkill();            /* compute Bgen and Bkill for LVs.      */
@@ -1163,15 +1208,21 @@ void flowlv()
         }
 
         tmp = vec_calloc(globsym.top);
+        work = worklist(0);
         cnt = 0;
         do
-        {       anychng = FALSE;
+        {       lvstats.passes++;
 
                 /* For each block B in reverse DFO order        */
                 for (i = dfotop; i--;)
                 {       register block *b = dfo[i];
                         register list_t bl = b->Bsucc;
 
+                        if (!vec_testbit(i,work))
+                                continue;
+                        vec_clearbit(i,work);
+                        lvstats.blocks++;
+
                         /* Bout = union of Bins of all successors to B. */
                         if (bl)
                         {       vec_copy(b->Boutlv,list_block(bl)->Binlv);
@@ -1187,13 +1238,15 @@ void flowlv()
                         /* Bin = (Bout - Bkill) | Bgen                  */
                         vec_sub(tmp,b->Boutlv,b->Bkill);
                         vec_orass(tmp,b->Bgen);
-                        if (!anychng)
-                                anychng = !vec_equal(tmp,b->Binlv);
-                        vec_copy(b->Binlv,tmp);
+                        if (!vec_equal(tmp,b->Binlv))
+                        {       vec_copy(b->Binlv,tmp);
+                                addwork(work,b->Bpred);
+                        }
                 }
                 cnt++;
                 assert(cnt < 50);
-        } while (anychng);
+        } while (vec_index(0,work) < dfotop);
+        vec_free(work);
         vec_free(tmp);
         vec_free(livexit);
 #if 0
@@ -1443,7 +1496,7 @@ STATIC void accumlv(vec_t GEN,vec_t KILL,elem *n)
 void flowvbe()
 {       vec_t tmp;
         unsigned i;
-        bool anychng;
+        vec_t work;
 
         flowxx = VBE;
         aecpgenkill();          /* compute Bgen and Bkill for VBEs      */
@@ -1479,16 +1532,21 @@ void flowvbe()
         }
 
         tmp = vec_calloc(exptop);
+        work = worklist(0);
         do
-        {       anychng = FALSE;
+        {       vbestats.passes++;
 
                 /* for all blocks except return blocks in reverse dfo order */
                 for (i = dfotop; i--;)
                 {       block *b = dfo[i];
                         list_t bl;
 
+                        if (!vec_testbit(i,work))
+                                continue;
+                        vec_clearbit(i,work);
                         if (b->BC == BCret || b->BC == BCretexp || b->BC == BCexit)
                                 continue;
+                        vbestats.blocks++;
 
                         /* Bout = & of Bin of all successors */
                         bl = b->Bsucc;
@@ -1504,11 +1562,13 @@ void flowvbe()
                         /* Bin = (Bout - Bkill) | Bgen  */
                         vec_sub(tmp,b->Bout,b->Bkill);
                         vec_orass(tmp,b->Bgen);
-                        if (!anychng)
-                                anychng = !vec_equal(tmp,b->Bin);
-                        vec_copy(b->Bin,tmp);
+                        if (!vec_equal(tmp,b->Bin))
+                        {       vec_copy(b->Bin,tmp);
+                                addwork(work,b->Bpred);
+                        }
                 }
-        } while (anychng);      /* while any changes occurred to any Bin */
+        } while (vec_index(0,work) < dfotop); /* while any changes occurred to any Bin */
+        vec_free(work);
         vec_free(tmp);
 }
 
@@ -70,6 +70,12 @@ void boolopt(void);
 void opt_arraybounds();
 
 /* gflow.c */
+struct FlowStats                // work done by a data flow analysis, for -v
+{
+    unsigned passes;            // passes over dfo[]
+    unsigned blocks;            // blocks whose flow sets were recomputed
+};
+extern FlowStats rdstats, aestats, cpstats, lvstats, vbestats;
 void flowrd(),flowlv(),flowae(),flowvbe(),
      flowcp(),flowae(),genkillae(),flowarraybounds();
 int ae_field_affect(elem *lvalue,elem *e);
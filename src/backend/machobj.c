@@ -101,6 +101,7 @@ static long elf_align(targ_size_t size, long offset);
 
 // String Table  - String table for all other names
 static Outbuffer *symtab_strings;
+static Strtab symtab_index;     // index of the strings in symtab_strings
 
 // Section Headers
 Outbuffer  *SECbuf;             // Buffer to build section table in
@@ -222,64 +223,14 @@ IDXSTR Obj::addstr(Outbuffer *strtab, const char *str)
 }
 
 /*******************************
- * Find a string in a string table
- * Input:
- *      strtab  =       string table for entry
- *      str     =       string to find
- *
- * Returns index into the specified string table or 0.
+ * Output a string into the symbol string table,
+ * unless it is already there.
+ * Returns index into the table.
  */
 
-static IDXSTR elf_findstr(Outbuffer *strtab, const char *str, const char *suffix)
+static IDXSTR elf_addsymstr(const char *str)
 {
-    const char *ent = (char *)strtab->buf+1;
-    const char *pend = ent+strtab->size() - 1;
-    const char *s = str;
-    const char *sx = suffix;
-    int len = strlen(str);
-
-    if (suffix)
-        len += strlen(suffix);
-
-    while(ent < pend)
-    {
-        if(*ent == 0)                   // end of table entry
-        {
-            if(*s == 0 && !sx)          // end of string - found a match
-            {
-                return ent - (const char *)strtab->buf - len;
-            }
-            else                        // table entry too short
-            {
-                s = str;                // back to beginning of string
-                sx = suffix;
-                ent++;                  // start of next table entry
-            }
-        }
-        else if (*s == 0 && sx && *sx == *ent)
-        {                               // matched first string
-            s = sx+1;                   // switch to suffix
-            ent++;
-            sx = NULL;
-        }
-        else                            // continue comparing
-        {
-            if (*ent == *s)
-            {                           // Have a match going
-                ent++;
-                s++;
-            }
-            else                        // no match
-            {
-                while(*ent != 0)        // skip to end of entry
-                    ent++;
-                ent++;                  // start of next table entry
-                s = str;                // back to beginning of string
-                sx = suffix;
-            }
-        }
-    }
-    return 0;                   // never found match
+    return symtab_index.add(str);
 }
 
 /*******************************
@@ -296,10 +247,8 @@ static IDXSTR elf_addmangled(Symbol *s)
     char dest[DEST_LEN];
     char *destr;
     const char *name;
-    int len;
     IDXSTR namidx;
 
-    namidx = symtab_strings->size();
     destr = obj_mangle2(s, dest);
     name = destr;
     if (CPP && name[0] == '_' && name[1] == '_')
@@ -333,13 +282,10 @@ static IDXSTR elf_addmangled(Symbol *s)
     }
     else if (tyfunc(s->ty()) && s->Sfunc && s->Sfunc->Fredirect)
         name = s->Sfunc->Fredirect;
-    len = strlen(name);
-    symtab_strings->reserve(len+1);
-    strcpy((char *)symtab_strings->p,name);
-    symtab_strings->setsize(namidx+len+1);
+    namidx = elf_addsymstr(name);
     if (destr != dest)                  // if we resized result
         mem_free(destr);
-    //dbg_printf("\telf_addmagled symtab_strings %s namidx %d len %d size %d\n",name, namidx,len,symtab_strings->size());
+    //dbg_printf("\telf_addmagled symtab_strings %s namidx %d size %d\n",name, namidx,symtab_strings->size());
     return namidx;
 }
 
@@ -437,6 +383,7 @@ Obj *Obj::init(Outbuffer *objbuf, const char *filename, const char *csegname)
         symtab_strings->reserve(2048);
         symtab_strings->writeByte(0);
     }
+    symtab_index.reset(symtab_strings);
 
     if (!local_symbuf)
         local_symbuf = new Outbuffer(sizeof(symbol *) * SYM_TAB_INIT);
@@ -1310,6 +1257,20 @@ void Obj::term(const char *objfilename)
     }
     foffset += symtab_cmd.nsyms * (I64 ? sizeof(struct nlist_64) : sizeof(struct nlist));
 
+    // Share string tails, and point the symbols at their new names
+    symtab_index.tailmerge();
+    for (int i = 0; i < symtab_cmd.nsyms; i++)
+    {
+        if (I64)
+        {   struct nlist_64 *psym = (struct nlist_64 *)(fobjbuf->buf + symtab_cmd.symoff) + i;
+            psym->n_un.n_strx = symtab_index.remap(psym->n_un.n_strx);
+        }
+        else
+        {   struct nlist *psym = (struct nlist *)(fobjbuf->buf + symtab_cmd.symoff) + i;
+            psym->n_un.n_strx = symtab_index.remap(psym->n_un.n_strx);
+        }
+    }
+
     // Put out string table
     foffset = elf_align(I64 ? 8 : 4, foffset);
     symtab_cmd.stroff = foffset;
@@ -2127,7 +2088,7 @@ int Obj::external_def(const char *name)
     //printf("Obj::external_def('%s')\n",name);
     assert(name);
     assert(extdef == 0);
-    extdef = Obj::addstr(symtab_strings, name);
+    extdef = elf_addsymstr(name);
     return 0;
 }
 
@@ -62,6 +62,7 @@ static long elf_align(int size, long offset);
 
 // String Table  - String table for all other names
 static Outbuffer *string_table;
+static Strtab string_index;     // index of the strings in string_table
 
 // Section Headers
 Outbuffer  *ScnhdrBuf;             // Buffer to build section table in
@@ -166,64 +167,14 @@ IDXSTR MsCoffObj::addstr(Outbuffer *strtab, const char *str)
 }
 
 /*******************************
- * Find a string in a string table
- * Input:
- *      strtab  =       string table for entry
- *      str     =       string to find
- *
- * Returns index into the specified string table or 0.
+ * Output a string into the string table,
+ * unless it is already there.
+ * Returns offset of the string in the string table.
  */
 
-static IDXSTR elf_findstr(Outbuffer *strtab, const char *str, const char *suffix)
+static IDXSTR elf_addsymstr(const char *str)
 {
-    const char *ent = (char *)strtab->buf+4;
-    const char *pend = ent+strtab->size() - 1;
-    const char *s = str;
-    const char *sx = suffix;
-    int len = strlen(str);
-
-    if (suffix)
-        len += strlen(suffix);
-
-    while(ent < pend)
-    {
-        if(*ent == 0)                   // end of table entry
-        {
-            if(*s == 0 && !sx)          // end of string - found a match
-            {
-                return ent - (const char *)strtab->buf - len;
-            }
-            else                        // table entry too short
-            {
-                s = str;                // back to beginning of string
-                sx = suffix;
-                ent++;                  // start of next table entry
-            }
-        }
-        else if (*s == 0 && sx && *sx == *ent)
-        {                               // matched first string
-            s = sx+1;                   // switch to suffix
-            ent++;
-            sx = NULL;
-        }
-        else                            // continue comparing
-        {
-            if (*ent == *s)
-            {                           // Have a match going
-                ent++;
-                s++;
-            }
-            else                        // no match
-            {
-                while(*ent != 0)        // skip to end of entry
-                    ent++;
-                ent++;                  // start of next table entry
-                s = str;                // back to beginning of string
-                sx = suffix;
-            }
-        }
-    }
-    return 0;                   // never found match
+    return string_index.add(str);
 }
 
 /*******************************
@@ -239,7 +190,6 @@ static IDXSTR elf_addmangled(Symbol *s)
     //printf("elf_addmangled(%s)\n", s->Sident);
     char dest[DEST_LEN];
 
-    IDXSTR namidx = string_table->size();
     char *destr = obj_mangle2(s, dest);
     const char *name = destr;
     if (CPP && name[0] == '_' && name[1] == '_')
@@ -273,13 +223,10 @@ static IDXSTR elf_addmangled(Symbol *s)
     }
     else if (tyfunc(s->ty()) && s->Sfunc && s->Sfunc->Fredirect)
         name = s->Sfunc->Fredirect;
-    size_t len = strlen(name);
-    string_table->reserve(len+1);
-    strcpy((char *)string_table->p,name);
-    string_table->setsize(namidx+len+1);
+    IDXSTR namidx = elf_addsymstr(name);
     if (destr != dest)                  // if we resized result
         mem_free(destr);
-    //dbg_printf("\telf_addmagled string_table %s namidx %d len %d size %d\n",name, namidx,len,string_table->size());
+    //dbg_printf("\telf_addmagled string_table %s namidx %d size %d\n",name, namidx,string_table->size());
     return namidx;
 }
 
@@ -383,6 +330,7 @@ MsCoffObj *MsCoffObj::init(Outbuffer *objbuf, const char *filename, const char *
     }
     string_table->setsize(0);
     string_table->write32(4);           // first 4 bytes are length of string table
+    string_index.reset(string_table);
 
     if (!symbuf)
         symbuf = new Outbuffer(sizeof(symbol *) * SYM_TAB_INIT);
@@ -556,7 +504,7 @@ static void syment_set_name(syment *sym, const char *name)
     size_t len = strlen(name);
     if (len > 8)
     {   // Use offset into string table
-        IDXSTR idx = MsCoffObj::addstr(string_table, name);
+        IDXSTR idx = elf_addsymstr(name);
         sym->n_zeroes = 0;
         sym->n_offset = idx;
     }
@@ -1568,7 +1516,7 @@ IDXSEC MsCoffObj::addScnhdr(const char *scnhdr_name, unsigned long flags)
     size_t len = strlen(scnhdr_name);
     if (len > 8)
     {   // Use /nnnn form
-        IDXSTR idx = addstr(string_table, scnhdr_name);
+        IDXSTR idx = elf_addsymstr(scnhdr_name);
         sprintf(sec.s_name, "/%d", idx);
     }
     else
@@ -31,6 +31,9 @@
 #include        "el.h"
 #include        "code.h"
 #endif
+#if MARS
+#include        "timetrace.h"
+#endif
 
 static char __file__[] = __FILE__;      /* for tassert.h                */
 #include        "tassert.h"
@@ -1155,7 +1158,13 @@ STATIC void writefunc2(symbol *sfunc)
     block_compbcount();                 // eliminate unreachable blocks
     if (mfoptim)
     {   OPTIMIZER = 1;
+#if MARS
+        TimeTrace::begin();
+#endif
         optfunc();                      /* optimize function            */
+#if MARS
+        TimeTrace::end("optfunc", sfunc->Sident);
+#endif
         assert(dfo);
         OPTIMIZER = 0;
     }
@@ -1218,10 +1227,16 @@ STATIC void writefunc2(symbol *sfunc)
     }
 
     //dbg_printf("codgen()\n");
+#if MARS
+    TimeTrace::begin();
+#endif
 #if SCPP
     if (!errcnt)
 #endif
         codgen();                               // generate code
+#if MARS
+    TimeTrace::end("codgen", sfunc->Sident);
+#endif
     //dbg_printf("after codgen for %s Coffset %x\n",sfunc->Sident,Coffset);
     blocklist_free(&startblock);
 #if SCPP
@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdio.h>
+#include <assert.h>
 
 #include "cc.h"
 
@@ -297,3 +298,220 @@ void Outbuffer::writeuLEB128(unsigned value)
     } while (value);
 }
 
+
+/************************* Strtab ****************************/
+
+static void *strtab_realloc(void *p, size_t size)
+{
+    p = realloc(p, size);
+    if (!p)
+    {
+        fprintf(stderr, "Fatal Error: Out of memory");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static unsigned strtab_hash(const unsigned char *s, size_t len)
+{
+    // FNV-1a
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ s[i]) * 16777619u;
+    return hash;
+}
+
+Strtab::Strtab()
+{
+    buf = NULL;
+    start = 0;
+    entries = NULL;
+    dim = 0;
+    allocdim = 0;
+    buckets = NULL;
+    nbuckets = 0;
+    merged = false;
+}
+
+Strtab::~Strtab()
+{
+    free(entries);
+    free(buckets);
+}
+
+void Strtab::reset(Outbuffer *strtab)
+{
+    buf = strtab;
+    start = strtab->size();
+    dim = 1;
+    merged = false;
+    if (nbuckets)
+        memset(buckets, 0, nbuckets * sizeof(unsigned));
+}
+
+void Strtab::rehash()
+{
+    nbuckets = nbuckets ? nbuckets * 2 : 256;
+    buckets = (unsigned *)strtab_realloc(buckets, nbuckets * sizeof(unsigned));
+    memset(buckets, 0, nbuckets * sizeof(unsigned));
+    for (unsigned i = 1; i < dim; i++)
+    {
+        Entry *e = &entries[i];
+        unsigned *pb = &buckets[e->hash & (nbuckets - 1)];
+        e->next = *pb;
+        *pb = i;
+    }
+}
+
+unsigned Strtab::add(const char *s)
+{
+    assert(buf && !merged);
+    size_t len = strlen(s);
+    unsigned hash = strtab_hash((const unsigned char *)s, len);
+
+    if (nbuckets)
+    {
+        for (unsigned i = buckets[hash & (nbuckets - 1)]; i; i = entries[i].next)
+        {
+            Entry *e = &entries[i];
+            if (e->hash == hash && e->len == len &&
+                memcmp(buf->buf + e->idx, s, len) == 0)
+                return e->idx;
+        }
+    }
+
+    if (dim >= allocdim)
+    {
+        allocdim = allocdim ? allocdim * 2 : 256;
+        entries = (Entry *)strtab_realloc(entries, allocdim * sizeof(Entry));
+    }
+    if (dim >= nbuckets)
+        rehash();
+
+    unsigned idx = buf->size();
+    buf->write(s, len + 1);
+
+    Entry *e = &entries[dim];
+    e->idx = idx;
+    e->len = len;
+    e->hash = hash;
+    unsigned *pb = &buckets[hash & (nbuckets - 1)];
+    e->next = *pb;
+    *pb = dim;
+    dim++;
+    return idx;
+}
+
+struct Tail
+{
+    const unsigned char *end;   // one past the last character
+    unsigned len;
+    unsigned entry;
+};
+
+// Order strings by their reversed contents, so that the strings
+// a string is the tail of follow right after it
+static int tail_cmp(const void *p1, const void *p2)
+{
+    const Tail *t1 = (const Tail *)p1;
+    const Tail *t2 = (const Tail *)p2;
+    const unsigned char *s1 = t1->end;
+    const unsigned char *s2 = t2->end;
+    unsigned n = t1->len < t2->len ? t1->len : t2->len;
+    for (unsigned i = 0; i < n; i++)
+    {
+        int c = *--s1 - *--s2;
+        if (c)
+            return c;
+    }
+    return (t1->len > t2->len) - (t1->len < t2->len);
+}
+
+void Strtab::tailmerge()
+{
+    assert(buf && !merged);
+    merged = true;
+    unsigned n = dim - 1;
+    if (!n)
+        return;
+
+    Tail *tails = (Tail *)strtab_realloc(NULL, n * sizeof(Tail));
+    for (unsigned i = 0; i < n; i++)
+    {
+        Entry *e = &entries[i + 1];
+        tails[i].end = buf->buf + e->idx + e->len;
+        tails[i].len = e->len;
+        tails[i].entry = i + 1;
+    }
+    qsort(tails, n, sizeof(Tail), &tail_cmp);
+
+    /* Find for each string the longest string it is the tail of,
+     * its owner. Owners point to themselves, and get newidx
+     * set to the offset of the tail within them.
+     */
+    unsigned *owner = (unsigned *)strtab_realloc(NULL, (n + 1) * sizeof(unsigned));
+    for (unsigned i = n; i--; )
+    {
+        Tail *t = &tails[i];
+        unsigned j = t->entry;
+        /* Only the next string can have t as its tail, and a shorter
+         * one can't: comparing with it would read from before its start.
+         */
+        if (i + 1 < n && tails[i + 1].len >= t->len &&
+            memcmp(tails[i + 1].end - t->len, t->end - t->len, t->len) == 0)
+        {
+            unsigned o = owner[tails[i + 1].entry];
+            owner[j] = o;
+            entries[j].newidx = entries[o].len - t->len;
+        }
+        else
+        {
+            owner[j] = j;
+            entries[j].newidx = 0;
+        }
+    }
+    free(tails);
+
+    // Write out the owners in their original order
+    size_t size = buf->size() - start;
+    unsigned char *old = (unsigned char *)strtab_realloc(NULL, size);
+    memcpy(old, buf->buf + start, size);
+    buf->setsize(start);
+    for (unsigned i = 1; i <= n; i++)
+    {
+        Entry *e = &entries[i];
+        if (owner[i] == i)
+        {
+            e->newidx = buf->size();
+            buf->write(old + e->idx - start, e->len + 1);
+        }
+    }
+    for (unsigned i = 1; i <= n; i++)
+    {
+        if (owner[i] != i)
+            entries[i].newidx += entries[owner[i]].newidx;
+    }
+    free(old);
+    free(owner);
+}
+
+unsigned Strtab::remap(unsigned idx)
+{
+    assert(merged);
+    if (idx < start)
+        return idx;
+
+    // entries are in order of idx
+    unsigned lo = 1;
+    unsigned hi = dim;
+    while (lo < hi)
+    {
+        unsigned mid = (lo + hi) / 2;
+        if (entries[mid].idx < idx)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    assert(lo < dim && entries[lo].idx == idx);
+    return entries[lo].newidx;
+}
@@ -196,3 +196,46 @@ struct Outbuffer
     void writeuLEB128(unsigned value);
 
 };
+
+// Hashed index of the strings in an object file string table,
+// so each distinct string is stored only once.
+
+struct Strtab
+{
+    Outbuffer *buf;             // the string table being indexed
+    unsigned start;             // offset of the first indexed string
+
+    struct Entry
+    {
+        unsigned idx;           // offset of string in buf
+        unsigned len;           // length of string, not counting the 0
+        unsigned hash;
+        unsigned next;          // next entry in hash chain, 0 for none
+        unsigned newidx;        // offset after tailmerge()
+    };
+    Entry *entries;             // entries[0] is unused
+    unsigned dim;
+    unsigned allocdim;
+    unsigned *buckets;          // heads of the hash chains
+    unsigned nbuckets;          // always a power of 2
+    bool merged;                // tailmerge() was done
+
+    Strtab();
+    ~Strtab();
+
+    // Index strings appended to strtab from now on
+    void reset(Outbuffer *strtab);
+
+    // Append s unless it is already there, return its offset
+    unsigned add(const char *s);
+
+    // Lay out the table again with strings that are the tail
+    // of another string pointing into it
+    void tailmerge();
+
+    // Offset after tailmerge() of string that was at idx
+    unsigned remap(unsigned idx);
+
+  private:
+    void rehash();
+};
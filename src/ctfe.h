@@ -15,6 +15,12 @@
 #endif /* __DMC__ */
 
 #include "arraytypes.h"
+#include "rmem.h"
+
+struct OutBuffer;
+
+// Maximum allowable recursive function calls in CTFE
+#define CTFE_RECURSION_LIMIT 1000
 
 /**
    Global status of the CTFE engine. Mostly used for performance diagnostics
@@ -22,14 +28,108 @@
 struct CtfeStatus
 {
     static int callDepth; // current number of recursive calls
+    static int evalDepth; // current number of nested ctfeInterpret() calls
     static int stackTraceCallsToSuppress; /* When printing a stack trace,
                                            * suppress this number of calls
                                            */
     static int maxCallDepth; // highest number of recursive calls
     static int numArrayAllocs; // Number of allocated arrays
     static int numAssignments; // total number of assignments executed
+    static int numBcCalls; // calls run by the bytecode VM
+    static int numBcAborts; // of those, the ones handed back to the interpreter
+    static int numMemoHits; // pure calls answered from the memo cache
+    static int numMemoMisses; // pure calls that had to be run and were cached
 };
 
+/**
+  The values CTFE makes while it evaluates an expression are allocated
+  in a region, which is freed once the result has been copied out of it
+ */
+struct CtfeRegion
+{
+    static bool active; // new Expressions are CTFE values
+    static bool pinned; // something outside the region may refer to it
+
+    MemMark mark;
+    bool wasActive;
+    bool wasPinned;
+
+    void begin();
+    Expression *end(Expression *e);
+};
+
+/// Allocate outside the region for the lifetime of the scope, for
+/// things that outlive the evaluation, such as semantic analysis
+struct CtfeRegionSuspend
+{
+    bool wasActive;
+
+    CtfeRegionSuspend()
+    {
+        wasActive = CtfeRegion::active;
+        CtfeRegion::active = false;
+    }
+
+    ~CtfeRegionSuspend()
+    {
+        CtfeRegion::active = wasActive;
+    }
+};
+
+/// Copy of the value e that doesn't use the region, or NULL if
+/// there's something in it that can't be copied
+Expression *copyOutOfRegion(Expression *e);
+
+/// Zeroed memory for the characters of a string made by CTFE,
+/// with room for a terminating 0
+void *allocCtfeString(size_t len, size_t sz);
+
+/**
+  Per function counts of the calls CTFE makes and what they cost,
+  recorded when -ctfeprofile is given
+ */
+struct CtfeProfile
+{
+    static Loc site;    // the compile time evaluation in progress
+
+    static void enter(FuncDeclaration *fd);
+    static void leave();
+    static void write(OutBuffer *buf, bool json);
+};
+
+/// Record the lifetime of the scope as one call of fd
+struct CtfeProfileScope
+{
+    bool recording;
+
+    CtfeProfileScope(FuncDeclaration *fd)
+    {
+        recording = global.params.ctfeProfile;
+        if (recording)
+            CtfeProfile::enter(fd);
+    }
+
+    ~CtfeProfileScope()
+    {
+        if (recording)
+            CtfeProfile::leave();
+    }
+};
+
+/**
+  Bytecode for the CTFE virtual machine, see ctfevm.c
+ */
+struct BcFunction;
+
+/// Return the bytecode for fd, or NULL if the VM cannot run it
+BcFunction *bcCompile(FuncDeclaration *fd);
+
+/// Same, but first bring fd through semantic3 like the interpreter does
+BcFunction *bcFunction(FuncDeclaration *fd);
+
+/// Run bf, returning NULL if the call needs to be interpreted instead
+Expression *bcRun(BcFunction *bf, Expressions *eargs);
+
 /**
   A reference to a class, or an interface. We need this when we
   point to a base class (we must record what the type is).
@@ -208,6 +308,10 @@ TypeAArray *toBuiltinAAType(Type *t);
  */
 Expression *findKeyInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2);
 
+/// Tell findKeyInAA() that the keys of 'ae' have changed other than by
+/// appending to them
+void resetAAIndex(AssocArrayLiteralExp *ae);
+
 /// True if type is TypeInfo_Class
 bool isTypeInfo_Class(Type *type);
 
@@ -236,12 +340,23 @@ int ctfeEqual(Loc loc, TOK op, Expression *e1, Expression *e2);
 /// Evaluate is, !is.  Resolves slices before comparing. Returns 0 or 1
 int ctfeIdentity(Loc loc, TOK op, Expression *e1, Expression *e2);
 
+/// Hash of a value, equal for values that ctfeEqual() finds equal
+hash_t ctfeHash(Expression *e);
+
 /// Evaluate >,<=, etc. Resolves slices before comparing. Returns 0 or 1
 int ctfeCmp(Loc loc, TOK op, Expression *e1, Expression *e2);
 
 /// Returns e1 ~ e2. Resolves slices before concatenation.
 Expression *ctfeCat(Type *type, Expression *e1, Expression *e2);
 
+/// Same as ctfeCat() for e1 ~= e2, where e1 is the value of a variable
+/// nothing else can refer to, but grows e1 in place if an earlier append
+/// made it. Returns NULL if it doesn't handle the combination.
+Expression *ctfeAppend(Type *type, Expression *e1, Expression *e2);
+
+/// e is leaving CTFE, so ctfeAppend() must not grow it any more
+void ctfeEndAppend(Expression *e);
+
 /// Same as for constfold.Index, except that it only works for static arrays,
 /// dynamic arrays, and strings.
 Expression *ctfeIndex(Loc loc, Type *type, Expression *e1, uinteger_t indx);
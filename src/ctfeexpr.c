@@ -13,6 +13,7 @@
 #include <string.h>                     // mem{cpy|set}()
 
 #include "rmem.h"
+#include "aav.h"
 
 #include "expression.h"
 #include "declaration.h"
@@ -21,6 +22,7 @@
 #include "id.h"
 #include "template.h"
 #include "ctfe.h"
+#include "utf.h"
 
 int RealEquals(real_t x1, real_t x2);
 
@@ -245,7 +247,7 @@ Expression *copyLiteral(Expression *e)
     if (e->op == TOKstring) // syntaxCopy doesn't make a copy for StringExp!
     {
         StringExp *se = (StringExp *)e;
-        utf8_t *s = (utf8_t *)mem.calloc(se->len + 1, se->sz);
+        utf8_t *s = (utf8_t *)allocCtfeString(se->len, se->sz);
         memcpy(s, se->string, se->len * se->sz);
         StringExp *se2 = new StringExp(se->loc, s, se->len);
         se2->committed = se->committed;
@@ -497,7 +499,7 @@ ArrayLiteralExp *createBlockDuplicatedArrayLiteral(Loc loc, Type *type,
 StringExp *createBlockDuplicatedStringLiteral(Loc loc, Type *type,
         unsigned value, size_t dim, unsigned char sz)
 {
-    utf8_t *s = (utf8_t *)mem.calloc(dim + 1, sz);
+    utf8_t *s = (utf8_t *)allocCtfeString(dim, sz);
     for (size_t elemi = 0; elemi < dim; ++elemi)
     {
         switch (sz)
@@ -1620,7 +1622,7 @@ Expression *ctfeCat(Type *type, Expression *e1, Expression *e2)
         size_t len = es1->len + es2->elements->dim;
         unsigned char sz = es1->sz;
 
-        void *s = mem.malloc((len + 1) * sz);
+        void *s = allocCtfeString(len, sz);
         memcpy((char *)s + sz * es2->elements->dim, es1->string, es1->len * sz);
         for (size_t i = 0; i < es2->elements->dim; i++)
         {
@@ -1651,7 +1653,7 @@ Expression *ctfeCat(Type *type, Expression *e1, Expression *e2)
         size_t len = es1->len + es2->elements->dim;
         unsigned char sz = es1->sz;
 
-        void *s = mem.malloc((len + 1) * sz);
+        void *s = allocCtfeString(len, sz);
         memcpy(s, es1->string, es1->len * sz);
         for (size_t i = 0; i < es2->elements->dim; i++)
         {
@@ -1701,26 +1703,534 @@ Expression *ctfeCat(Type *type, Expression *e1, Expression *e2)
     return Cat(type, e1, e2);
 }
 
-/*  Given an AA literal 'ae', and a key 'e2':
- *  Return ae[e2] if present, or NULL if not found.
+/* Strings and array literals made by ctfeAppend() => their capacity in
+ * elements. Nothing else refers to them while they are the value of the
+ * variable being appended to, so they can be grown in place.
  */
-Expression *findKeyInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2)
+static AA *appendable;
+
+static size_t appendCapacity(size_t len)
 {
-    /* Search the keys backwards, in case there are duplicate keys
-     */
-    for (size_t i = ae->keys->dim; i;)
+    return len < 8 ? 16 : len * 2;
+}
+
+Expression *ctfeAppend(Type *type, Expression *e1, Expression *e2)
+{
+    Type *t1 = e1->type->toBasetype();
+    Type *t2 = e2->type->toBasetype();
+    size_t cap = (size_t)_aaGetRvalue(appendable, e1);
+    if (e1->op == TOKstring)
     {
-        i--;
-        Expression *ekey = (*ae->keys)[i];
-        int eq = ctfeEqual(loc, TOKequal, ekey, e2);
-        if (eq)
+        // The same cases as in ctfeCat() and Cat() that give a string
+        StringExp *es1 = (StringExp *)e1;
+        unsigned char sz = es1->sz;
+        unsigned char committed = es1->committed;
+        size_t n;
+        if (e2->op == TOKstring)
+        {
+            StringExp *es2 = (StringExp *)e2;
+            if (es2->sz != sz)
+                return NULL;
+            n = es2->len;
+            committed |= es2->committed;
+        }
+        else if (e2->op == TOKint64)
         {
-            return (*ae->values)[i];
+            n = sz == t2->size() ? 1 : utf_codeLength(sz, (dchar_t)e2->toInteger());
+        }
+        else if (e2->op == TOKarrayliteral && t2->nextOf()->isintegral())
+        {
+            ArrayLiteralExp *ea = (ArrayLiteralExp *)e2;
+            n = ea->elements->dim;
+            for (size_t i = 0; i < n; i++)
+            {
+                if ((*ea->elements)[i]->op != TOKint64)
+                    return NULL;
+            }
+            committed = 0;
         }
+        else
+            return NULL;
+
+        size_t len = es1->len + n;
+        StringExp *es = es1;
+        if (len > cap)
+        {
+            size_t newcap = appendCapacity(len);
+            void *s = allocCtfeString(newcap, sz);
+            memcpy(s, es1->string, es1->len * sz);
+            if (!cap)
+            {
+                es = new StringExp(es1->loc, s, es1->len);
+                es->sz = sz;
+            }
+            else
+                es->string = s;
+            *(size_t *)_aaGet(&appendable, es) = newcap;
+        }
+
+        utf8_t *p = (utf8_t *)es->string + es->len * sz;
+        if (e2->op == TOKstring)
+            memcpy(p, ((StringExp *)e2)->string, n * sz);
+        else if (e2->op == TOKint64)
+        {
+            dinteger_t v = e2->toInteger();
+            if (sz == t2->size())
+                memcpy(p, &v, sz);
+            else
+                utf_encode(sz, p, (dchar_t)v);
+        }
+        else
+        {
+            ArrayLiteralExp *ea = (ArrayLiteralExp *)e2;
+            for (size_t i = 0; i < n; i++)
+            {
+                dinteger_t v = (*ea->elements)[i]->toInteger();
+                memcpy(p + i * sz, &v, sz);
+            }
+        }
+        // Add terminating 0
+        memset((utf8_t *)es->string + len * sz, 0, sz);
+
+        es->len = len;
+        es->committed = committed;
+        es->type = type;
+        return es;
+    }
+    else if (e1->op == TOKarrayliteral)
+    {
+        // The same cases as in ctfeCat() and Cat() that give an array literal
+        ArrayLiteralExp *es1 = (ArrayLiteralExp *)e1;
+        Type *tn = t1->nextOf();
+        Expressions *elems = NULL;
+        if (e2->op == TOKarrayliteral)
+        {
+            if (!tn->equals(t2->nextOf()))
+                return NULL;
+            elems = copyLiteralArray(((ArrayLiteralExp *)e2)->elements);
+        }
+        else if (!tn->equals(e2->type))
+            return NULL;
+
+        size_t len = es1->elements->dim + (elems ? elems->dim : 1);
+        ArrayLiteralExp *ea = es1;
+        if (len > cap)
+        {
+            if (!cap)
+                ea = new ArrayLiteralExp(es1->loc, copyLiteralArray(es1->elements));
+            size_t newcap = appendCapacity(len);
+            ea->elements->reserve(newcap - ea->elements->dim);
+            *(size_t *)_aaGet(&appendable, ea) = newcap;
+        }
+        if (elems)
+            ea->elements->append(elems);
+        else
+            ea->elements->push(e2);
+        ea->type = type;
+        return ea;
     }
     return NULL;
 }
 
+void ctfeEndAppend(Expression *e)
+{
+    _aaDel(appendable, e);
+}
+
+/******************************** CtfeRegion **************************/
+
+static void freeAAIndexes();
+
+bool CtfeRegion::active = false;
+bool CtfeRegion::pinned = false;
+
+void *allocCtfeString(size_t len, size_t sz)
+{
+    size_t size = (len + 1) * sz;
+    void *s = CtfeRegion::active ? mem.allocate(MEMctfe, size) : mem.malloc(size);
+    memset(s, 0, size);
+    return s;
+}
+
+/* Copies the values of a CTFE result, keeping the sharing between them
+ */
+struct CopyOut
+{
+    AA *copies;         // value => its copy
+    bool failed;
+
+    CopyOut() : copies(NULL), failed(false) { }
+
+    Expression *copy(Expression *e);
+    Expressions *copy(Expressions *exps);
+};
+
+Expressions *CopyOut::copy(Expressions *exps)
+{
+    if (!exps)
+        return NULL;
+    Expressions *r = new Expressions();
+    r->setDim(exps->dim);
+    for (size_t i = 0; i < exps->dim; i++)
+        (*r)[i] = copy((*exps)[i]);
+    return r;
+}
+
+Expression *CopyOut::copy(Expression *e)
+{
+    if (!e || failed)
+        return NULL;
+    if (e == EXP_CANT_INTERPRET || e == EXP_VOID_INTERPRET)
+        return e;               // not values, see Expression::init()
+    Expression **pcopy = (Expression **)_aaGet(&copies, e);
+    if (*pcopy)
+        return *pcopy;
+    Expression *r = e->copy();
+    *pcopy = r;                 // before the operands, for class references
+    switch (e->op)
+    {
+        case TOKint64:
+        case TOKfloat64:
+        case TOKcomplex80:
+        case TOKnull:
+        case TOKvar:
+        case TOKsymoff:
+        case TOKfunction:
+        case TOKtype:
+        case TOKerror:
+        case TOKvoid:
+            break;
+
+        case TOKstring:
+        {
+            StringExp *se = (StringExp *)r;
+            void *s = allocCtfeString(se->len, se->sz);
+            memcpy(s, se->string, se->len * se->sz);
+            se->string = s;
+            break;
+        }
+        case TOKarrayliteral:
+            ((ArrayLiteralExp *)r)->elements = copy(((ArrayLiteralExp *)e)->elements);
+            break;
+
+        case TOKassocarrayliteral:
+            ((AssocArrayLiteralExp *)r)->keys = copy(((AssocArrayLiteralExp *)e)->keys);
+            ((AssocArrayLiteralExp *)r)->values = copy(((AssocArrayLiteralExp *)e)->values);
+            break;
+
+        case TOKstructliteral:
+        {
+            StructLiteralExp *se = (StructLiteralExp *)r;
+            se->elements = copy(((StructLiteralExp *)e)->elements);
+            se->origin = se;
+            se->inlinecopy = NULL;
+            break;
+        }
+        case TOKclassreference:
+            ((ClassReferenceExp *)r)->value = (StructLiteralExp *)copy(((ClassReferenceExp *)e)->value);
+            break;
+
+        case TOKtuple:
+            ((TupleExp *)r)->e0 = copy(((TupleExp *)e)->e0);
+            ((TupleExp *)r)->exps = copy(((TupleExp *)e)->exps);
+            break;
+
+        // Pointers and delegates
+        case TOKaddress:
+        case TOKdotvar:
+        case TOKdelegate:
+        case TOKcast:
+            ((UnaExp *)r)->e1 = copy(((UnaExp *)e)->e1);
+            break;
+
+        case TOKindex:
+            ((IndexExp *)r)->e1 = copy(((IndexExp *)e)->e1);
+            ((IndexExp *)r)->e2 = copy(((IndexExp *)e)->e2);
+            break;
+
+        case TOKslice:
+            ((SliceExp *)r)->e1 = copy(((SliceExp *)e)->e1);
+            ((SliceExp *)r)->lwr = copy(((SliceExp *)e)->lwr);
+            ((SliceExp *)r)->upr = copy(((SliceExp *)e)->upr);
+            break;
+
+        default:
+            failed = true;
+            break;
+    }
+    return failed ? NULL : r;
+}
+
+Expression *copyOutOfRegion(Expression *e)
+{
+    CtfeRegionSuspend crs;
+    CopyOut co;
+    return co.copy(e);
+}
+
+void CtfeRegion::begin()
+{
+    mem.mark(MEMctfe, &mark);
+    wasActive = active;
+    wasPinned = pinned;
+    active = true;
+    pinned = false;
+}
+
+/* Return a copy of the result e that doesn't use the region, and free
+ * the region unless something else may refer to it.
+ */
+Expression *CtfeRegion::end(Expression *e)
+{
+    active = false;
+    MemStats stats;
+    mem.takeStats(&stats);
+    mem.addStats(&stats);
+    if (stats.objects[MEMctfe] != mark.objects && !pinned)
+    {
+        // The result may be some of the values, or refer to them
+        Expression *ecopy = copyOutOfRegion(e);
+        if (ecopy)
+        {
+            e = ecopy;
+            mem.release(MEMctfe, &mark);
+            // The nodes they know about are gone
+            appendable = NULL;
+            freeAAIndexes();
+        }
+        else
+            pinned = true;
+    }
+    if (!wasActive)
+        freeAAIndexes();        // the evaluation is over
+    active = wasActive;
+    pinned |= wasPinned;
+    return e;
+}
+
+/* Hash of a CTFE value, such that values ctfeEqual() finds equal
+ * have the same hash.
+ */
+hash_t ctfeHash(Expression *e)
+{
+    Type *tb = e->type->toBasetype();
+    if (tb->ty == Tpointer || tb->ty == Tdelegate || tb->ty == Tclass ||
+        e->op == TOKclassreference)
+        return 0;               // compared by identity, see ctfeRawCmp()
+    if (isArray(e))
+    {
+        size_t lwr = 0;
+        size_t len = (size_t)resolveArrayLength(e);
+        if (e->op == TOKslice)
+        {
+            lwr = (size_t)((SliceExp *)e)->lwr->toInteger();
+            e = ((SliceExp *)e)->e1;
+        }
+        hash_t h = len;
+        for (size_t i = 0; i < len; i++)
+        {
+            hash_t eh;
+            if (e->op == TOKstring)
+                eh = ((StringExp *)e)->charAt(lwr + i);
+            else
+                eh = ctfeHash((*((ArrayLiteralExp *)e)->elements)[lwr + i]);
+            h = h * 31 + eh;
+        }
+        return h;
+    }
+    if (tb->isintegral())
+        return (hash_t)e->toInteger();
+    if (tb->isreal() || tb->isimaginary() || tb->iscomplex())
+    {
+        real_t r[2];
+        if (tb->isreal())
+        {   r[0] = e->toReal();
+            r[1] = 0;
+        }
+        else if (tb->isimaginary())
+        {   r[0] = e->toImaginary();
+            r[1] = 0;
+        }
+        else
+        {   complex_t c = e->toComplex();
+            r[0] = creall(c);
+            r[1] = cimagl(c);
+        }
+        hash_t h = 0;
+        for (size_t i = 0; i < 2; i++)
+        {
+            // Equal reals can differ in their padding, and 0.0 == -0.0
+            double d = (double)r[i];
+            d_uns64 bits = 0;
+            if (d != 0 && !Port::isNan(d))
+                memcpy(&bits, &d, sizeof(d));
+            h = h * 31 + (hash_t)(bits ^ (bits >> 32));
+        }
+        return h;
+    }
+    if (e->op == TOKstructliteral)
+    {
+        Expressions *elems = ((StructLiteralExp *)e)->elements;
+        hash_t h = 0;
+        for (size_t i = 0; elems && i < elems->dim; i++)
+        {
+            Expression *ee = (*elems)[i];
+            h = h * 31 + (ee ? ctfeHash(ee) : 0);
+        }
+        return h;
+    }
+    return 0;
+}
+
+/* A hash table of the positions of an AA literal's keys, so that lookups
+ * don't have to compare against every key. It is kept for the keys array
+ * rather than the literal, which may be painted to other types, and
+ * catches up with keys appended since the last lookup.
+ */
+struct AAIndex
+{
+    Expressions *keys;
+    size_t nkeys;               // keys[0 .. nkeys] are in the table
+    size_t nslots;              // a power of 2
+    size_t *slots;              // 1 + position in keys, or 0 if empty
+    hash_t *hashes;             // of the key in each slot
+    bool stale;                 // keys changed other than by appending
+    AAIndex *next;              // in aaIndexList
+};
+
+static AA *aaIndexes;           // keys array => AAIndex
+static AAIndex *aaIndexList;    // all of the AAIndexes, so they can be freed
+
+/* Lookups in AAs with fewer keys than this just search the keys
+ */
+#define AA_INDEX_MIN 8
+
+static void aaIndexInsert(Loc loc, AAIndex *ai, size_t i)
+{
+    if ((ai->nkeys + 1) * 2 > ai->nslots)
+    {
+        size_t nslots = ai->nslots ? ai->nslots * 2 : 32;
+        size_t *slots = (size_t *)mem.calloc(nslots, sizeof(size_t));
+        hash_t *hashes = (hash_t *)mem.malloc(nslots * sizeof(hash_t));
+        for (size_t j = 0; j < ai->nslots; j++)
+        {
+            if (!ai->slots[j])
+                continue;
+            size_t k = ai->hashes[j] & (nslots - 1);
+            while (slots[k])
+                k = (k + 1) & (nslots - 1);
+            slots[k] = ai->slots[j];
+            hashes[k] = ai->hashes[j];
+        }
+        mem.free(ai->slots);
+        mem.free(ai->hashes);
+        ai->slots = slots;
+        ai->hashes = hashes;
+        ai->nslots = nslots;
+    }
+
+    Expression *ekey = (*ai->keys)[i];
+    hash_t h = ctfeHash(ekey);
+    size_t k = h & (ai->nslots - 1);
+    for (; ai->slots[k]; k = (k + 1) & (ai->nslots - 1))
+    {
+        if (ai->hashes[k] == h &&
+            ctfeEqual(loc, TOKequal, (*ai->keys)[ai->slots[k] - 1], ekey))
+        {   // A later duplicate hides an earlier one
+            ai->slots[k] = i + 1;
+            ai->nkeys++;
+            return;
+        }
+    }
+    ai->slots[k] = i + 1;
+    ai->hashes[k] = h;
+    ai->nkeys++;
+}
+
+/* Return 1 + the position of key e2 in ae's keys, or 0 if not found.
+ */
+static size_t findKeyIndexInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2)
+{
+    Expressions *keys = ae->keys;
+    if (keys->dim < AA_INDEX_MIN)
+    {
+        /* Search the keys backwards, in case there are duplicate keys
+         */
+        for (size_t i = keys->dim; i;)
+        {
+            i--;
+            Expression *ekey = (*keys)[i];
+            int eq = ctfeEqual(loc, TOKequal, ekey, e2);
+            if (eq)
+                return i + 1;
+        }
+        return 0;
+    }
+
+    AAIndex **pai = (AAIndex **)_aaGet(&aaIndexes, keys);
+    AAIndex *ai = *pai;
+    if (!ai)
+    {
+        ai = (AAIndex *)mem.calloc(1, sizeof(AAIndex));
+        ai->keys = keys;
+        ai->next = aaIndexList;
+        aaIndexList = ai;
+        *pai = ai;
+    }
+    else if (ai->stale || ai->nkeys > keys->dim)
+    {   // Rebuild it
+        if (ai->slots)
+            memset(ai->slots, 0, ai->nslots * sizeof(size_t));
+        ai->nkeys = 0;
+        ai->stale = false;
+    }
+    while (ai->nkeys < keys->dim)
+        aaIndexInsert(loc, ai, ai->nkeys);
+
+    hash_t h = ctfeHash(e2);
+    for (size_t k = h & (ai->nslots - 1); ai->slots[k]; k = (k + 1) & (ai->nslots - 1))
+    {
+        if (ai->hashes[k] == h &&
+            ctfeEqual(loc, TOKequal, (*keys)[ai->slots[k] - 1], e2))
+            return ai->slots[k];
+    }
+    return 0;
+}
+
+/* The keys of ae have changed other than by appending to them
+ */
+void resetAAIndex(AssocArrayLiteralExp *ae)
+{
+    AAIndex *ai = (AAIndex *)_aaGetRvalue(aaIndexes, ae->keys);
+    if (ai)
+        ai->stale = true;
+}
+
+/* Free the hash indexes of all AAs. They are rebuilt as needed.
+ */
+static void freeAAIndexes()
+{
+    for (AAIndex *ai = aaIndexList; ai;)
+    {
+        AAIndex *next = ai->next;
+        mem.free(ai->slots);
+        mem.free(ai->hashes);
+        mem.free(ai);
+        ai = next;
+    }
+    aaIndexList = NULL;
+    aaIndexes = NULL;
+}
+
+/*  Given an AA literal 'ae', and a key 'e2':
+ *  Return ae[e2] if present, or NULL if not found.
+ */
+Expression *findKeyInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2)
+{
+    size_t i = findKeyIndexInAA(loc, ae, e2);
+    return i ? (*ae->values)[i - 1] : NULL;
+}
+
 /* Same as for constfold.Index, except that it only works for static arrays,
  * dynamic arrays, and strings. We know that e1 is an
  * interpreted CTFE expression, so it cannot have side-effects.
@@ -1915,18 +2425,10 @@ Expression *assignAssocArrayElement(Loc loc, AssocArrayLiteralExp *aae,
      */
     Expressions *keysx = aae->keys;
     Expressions *valuesx = aae->values;
-    int updated = 0;
-    for (size_t j = valuesx->dim; j; )
-    {   j--;
-        Expression *ekey = (*aae->keys)[j];
-        int eq = ctfeEqual(loc, TOKequal, ekey, index);
-        if (eq)
-        {
-            (*valuesx)[j] = newval;
-            updated = 1;
-        }
-    }
-    if (!updated)
+    size_t j = findKeyIndexInAA(loc, aae, index);
+    if (j)
+        (*valuesx)[j - 1] = newval;
+    else
     {   // Append index/newval to keysx[]/valuesx[]
         valuesx->push(newval);
         keysx->push(index);
@@ -1956,7 +2458,7 @@ Expression *changeArrayLiteralLength(Loc loc, TypeArray *arrayType,
     if (oldval->op == TOKstring)
     {
         StringExp *oldse = (StringExp *)oldval;
-        utf8_t *s = (utf8_t *)mem.calloc(newlen + 1, oldse->sz);
+        utf8_t *s = (utf8_t *)allocCtfeString(newlen, oldse->sz);
         memcpy(s, oldse->string, copylen * oldse->sz);
         unsigned defaultValue = (unsigned)(defaultElem->toInteger());
         for (size_t elemi = copylen; elemi < newlen; ++elemi)
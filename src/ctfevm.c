@@ -0,0 +1,1687 @@
+
+// Compiler implementation of the D programming language
+// Copyright (c) 2014 by Digital Mars
+// All Rights Reserved
+// http://www.digitalmars.com
+// License for redistribution is by either the Artistic License
+// in artistic.txt, or the GNU General Public License in gnu.txt.
+// See the included readme.txt for details.
+
+/* A register based bytecode compiler and virtual machine for the
+ * common CTFE case of functions that compute on integers and arrays
+ * of integers: loop and recursion heavy table generators spend most
+ * of their time here. Values live in machine words and packed
+ * buffers instead of freshly allocated Expression nodes, and are
+ * only turned back into literals when they leave the VM.
+ *
+ * A function is compiled only if everything it does is supported,
+ * and it can then only touch its own parameters and locals. So
+ * when the VM meets anything it does not want to deal with (a failed
+ * assert, a division by zero, a callee that does not compile, ...)
+ * it gives up, and the interpreter redoes the call from scratch and
+ * produces the usual diagnostics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "rmem.h"
+#include "aav.h"
+
+#include "statement.h"
+#include "expression.h"
+#include "init.h"
+#include "mtype.h"
+#include "declaration.h"
+#include "ctfe.h"
+#include "visitor.h"
+
+#define LOG 0
+
+enum BcOp
+{
+    BCimm,          // r[dst] = imm
+    BCnorm,         // r[dst] = normalize(r[a])
+    BCadd,          // r[dst] = normalize(r[a] op r[b])
+    BCsub,
+    BCmul,
+    BCand,
+    BCor,
+    BCxor,
+    BCdivs,         // signed and unsigned division and remainder
+    BCdivu,
+    BCmods,
+    BCmodu,
+    BCshl,          // shifts, imm is the width of the shifted type in bits
+    BCshrs,
+    BCshru,
+    BCushr,
+    BCneg,          // r[dst] = normalize(op r[a])
+    BCcom,
+    BCnot,          // r[dst] = r[a] == 0
+    BCbool,         // r[dst] = r[a] != 0
+    BCeq,           // r[dst] = r[a] op r[b]
+    BCne,
+    BClt,
+    BCle,
+    BCgt,
+    BCge,
+    BCltu,
+    BCleu,
+    BCgtu,
+    BCgeu,
+    BCnewarr,       // r[dst] = new array of r[a] elements of value imm, b is BUFxxxx flags
+    BCarrlit,       // r[dst] = new array of r[a] .. r[a + b], imm is BUFxxxx flags
+                    // (for both, norm is that of the elements)
+    BClen,          // r[dst] = r[a].length
+    BCsetlen,       // r[dst] = copy of r[a] with length r[b], new elements are imm, norm is theirs
+    BCload,         // r[dst] = r[a][r[b]]
+    BCstore,        // r[dst][r[a]] = r[b]
+    BCslice,        // r[dst] = r[a][r[b] .. r[imm]]
+    BCblit,         // r[dst][] = r[a][]
+    BCfill,         // r[dst][] = r[a]
+    BCjmp,          // goto imm
+    BCjz,           // if (r[a] == 0) goto imm
+    BCjnz,          // if (r[a] != 0) goto imm
+    BCcall,         // r[dst] = callees[imm](r[a] .. r[a + b])
+    BCret,          // return normalize(r[a]), imm indexes retlocs[]
+    BCassert,       // give up if r[a] == 0
+    BCabort,        // give up
+};
+
+/* How to bring a value into the canonical form IntegerExp::toInteger()
+ * gives it for a type.
+ */
+enum BcNorm
+{
+    NORMnone,
+    NORMbool,
+    NORMi8,
+    NORMu8,
+    NORMi16,
+    NORMu16,
+    NORMi32,
+    NORMu32,
+};
+
+struct BcInstr
+{
+    unsigned char op;
+    unsigned char norm;
+    unsigned dst;
+    unsigned a;
+    unsigned b;
+    sinteger_t imm;
+};
+
+struct BcFunction
+{
+    FuncDeclaration *fd;
+    bool ok;                    // false if fd cannot be run by the VM
+    BcInstr *code;
+    size_t codedim;
+    unsigned nregs;             // frame size
+    unsigned nparams;           // parameters are registers 0 .. nparams-1
+    unsigned char *paramnorm;
+    unsigned char retnorm;
+    Type *tret;
+    FuncDeclarations callees;
+    Loc *retlocs;               // location of each return statement's expression
+    bool memoizable;            // -ctfememo caches the results of calls made by the VM
+    AA *memo;                   // hash of the arguments => BcMemo list
+
+    BcFunction(FuncDeclaration *fd)
+    {
+        this->fd = fd;
+        ok = false;
+        code = NULL;
+        codedim = 0;
+        nregs = 0;
+        nparams = 0;
+        paramnorm = NULL;
+        retnorm = NORMnone;
+        tret = NULL;
+        retlocs = NULL;
+        memoizable = false;
+        memo = NULL;
+    }
+};
+
+/* A previous call of a memoized function, see -ctfememo
+ */
+struct BcMemo
+{
+    BcMemo *next;               // next entry whose arguments have the same hash
+    sinteger_t result;
+    sinteger_t args[1];         // nparams of them
+};
+
+static int normOf(Type *t)
+{
+    switch (t->toBasetype()->ty)
+    {
+        case Tbool:     return NORMbool;
+        case Tint8:     return NORMi8;
+        case Tuns8:
+        case Tchar:     return NORMu8;
+        case Tint16:    return NORMi16;
+        case Tuns16:
+        case Twchar:    return NORMu16;
+        case Tint32:    return NORMi32;
+        case Tuns32:
+        case Tdchar:    return NORMu32;
+        case Tint64:
+        case Tuns64:    return NORMnone;
+        default:        return -1;          // not supported
+    }
+}
+
+static inline sinteger_t normalize(sinteger_t v, int norm)
+{
+    switch (norm)
+    {
+        case NORMbool:  return v != 0;
+        case NORMi8:    return (d_int8)v;
+        case NORMu8:    return (d_uns8)v;
+        case NORMi16:   return (d_int16)v;
+        case NORMu16:   return (d_uns16)v;
+        case NORMi32:   return (d_int32)v;
+        case NORMu32:   return (d_uns32)v;
+        default:        return v;
+    }
+}
+
+/************************************
+ * Arrays of scalars. There is one buffer for each array literal the
+ * interpreter would have created, with the elements packed. A register
+ * holds a pointer to a BcSlice of one, or 0 for a null array; slices
+ * are never changed once made, so registers can share them.
+ */
+
+enum
+{
+    BUFreadonly  = 1,   // a literal, or copied in from the interpreter
+    BUFstring    = 2,   // the interpreter would have a StringExp for it
+    BUFcommitted = 4,   // and StringExp::committed would be set
+    BUFmutable   = 8,   // copied in, and the interpreter's original may still change
+};
+
+struct BcBuffer
+{
+    unsigned char *data;
+    size_t dim;
+    unsigned char norm;         // of the elements
+    unsigned char flags;
+};
+
+struct BcSlice
+{
+    BcBuffer *buf;
+    size_t lwr;
+    size_t length;
+};
+
+/* Dynamic arrays are supported if their elements are scalars
+ * the VM can normalize
+ */
+static bool isScalarArray(Type *t)
+{
+    t = t->toBasetype();
+    return t->ty == Tarray && normOf(t->nextOf()) >= 0;
+}
+
+static bool isSupported(Type *t)
+{
+    return normOf(t) >= 0 || isScalarArray(t);
+}
+
+/* The normalization to apply when copying a value of type t
+ */
+static int regNorm(Type *t)
+{
+    int norm = normOf(t);
+    return norm >= 0 ? norm : NORMnone;
+}
+
+static size_t elemSize(int norm)
+{
+    switch (norm)
+    {
+        case NORMbool:
+        case NORMi8:
+        case NORMu8:    return 1;
+        case NORMi16:
+        case NORMu16:   return 2;
+        case NORMi32:
+        case NORMu32:   return 4;
+        default:        return 8;
+    }
+}
+
+static inline sinteger_t getElem(BcBuffer *b, size_t i)
+{
+    switch (b->norm)
+    {
+        case NORMbool:
+        case NORMu8:    return b->data[i];
+        case NORMi8:    return (d_int8)b->data[i];
+        case NORMi16:   return ((d_int16 *)b->data)[i];
+        case NORMu16:   return ((d_uns16 *)b->data)[i];
+        case NORMi32:   return ((d_int32 *)b->data)[i];
+        case NORMu32:   return ((d_uns32 *)b->data)[i];
+        default:        return ((sinteger_t *)b->data)[i];
+    }
+}
+
+static inline void setElem(BcBuffer *b, size_t i, sinteger_t v)
+{
+    switch (b->norm)
+    {
+        case NORMbool:  b->data[i] = v != 0;                    break;
+        case NORMi8:
+        case NORMu8:    b->data[i] = (d_uns8)v;                 break;
+        case NORMi16:
+        case NORMu16:   ((d_uns16 *)b->data)[i] = (d_uns16)v;   break;
+        case NORMi32:
+        case NORMu32:   ((d_uns32 *)b->data)[i] = (d_uns32)v;   break;
+        default:        ((sinteger_t *)b->data)[i] = v;         break;
+    }
+}
+
+/* A buffer for dim elements, with room for a terminating 0 in case
+ * it becomes a StringExp.
+ * Buffers and slices are only referred to by the VM's registers and
+ * each other: exportArray() copies them into literals allocated the way
+ * the interpreter allocates its values, so none of them escape bcRun().
+ * Whether or not a CtfeRegion is active, they are allocated from
+ * MEMctfe so that an enclosing region frees them. Evaluations nested in
+ * a call the VM makes mark the region after them, so their release never
+ * frees buffers that are still in use.
+ */
+static BcBuffer *newBuffer(size_t dim, int norm, int flags)
+{
+    BcBuffer *b = (BcBuffer *)mem.allocate(MEMctfe, sizeof(BcBuffer));
+    b->data = (unsigned char *)mem.allocate(MEMctfe, (dim + 1) * elemSize(norm));
+    b->dim = dim;
+    b->norm = (unsigned char)norm;
+    b->flags = (unsigned char)flags;
+    return b;
+}
+
+static BcSlice *newSlice(BcBuffer *b, size_t lwr, size_t length)
+{
+    BcSlice *s = (BcSlice *)mem.allocate(MEMctfe, sizeof(BcSlice));
+    s->buf = b;
+    s->lwr = lwr;
+    s->length = length;
+    return s;
+}
+
+static inline BcSlice *toSlice(sinteger_t v)
+{
+    return (BcSlice *)(size_t)v;
+}
+
+static inline sinteger_t fromSlice(BcSlice *s)
+{
+    return (sinteger_t)(size_t)s;
+}
+
+/* The interpreter makes StringExps for new arrays of characters
+ */
+static int newArrayFlags(Type *telem)
+{
+    if (telem->ty == Tchar || telem->ty == Twchar || telem->ty == Tdchar)
+        return BUFstring | BUFcommitted;
+    return 0;
+}
+
+/************************************
+ * Compiler.
+ */
+
+struct BcLoop
+{
+    BcLoop *outer;
+    Array<size_t> breaks;       // jumps to patch to the end of the loop
+    Array<size_t> continues;    // jumps to patch to the continue target
+};
+
+class BcCompiler : public Visitor
+{
+public:
+    BcFunction *bf;
+    bool failed;
+    AA *vars;                   // VarDeclaration => register + 1
+    unsigned top;               // next free register
+    unsigned floor;             // registers below this hold variables
+    unsigned result;            // register holding the value of the last expression
+    BcLoop *loop;
+    Array<BcInstr> code;
+    Array<Loc> retlocs;
+
+    BcCompiler(BcFunction *bf)
+    {
+        this->bf = bf;
+        failed = false;
+        vars = NULL;
+        top = 0;
+        floor = 0;
+        result = 0;
+        loop = NULL;
+    }
+
+    size_t emit(int op, unsigned dst = 0, unsigned a = 0, unsigned b = 0, sinteger_t imm = 0, int norm = NORMnone)
+    {
+        BcInstr in;
+        in.op = (unsigned char)op;
+        in.norm = (unsigned char)norm;
+        in.dst = dst;
+        in.a = a;
+        in.b = b;
+        in.imm = imm;
+        code.push(in);
+        return code.dim - 1;
+    }
+
+    void patch(size_t i)
+    {
+        code[i].imm = code.dim;
+    }
+
+    unsigned temp()
+    {
+        unsigned r = top++;
+        if (top > bf->nregs)
+            bf->nregs = top;
+        return r;
+    }
+
+    unsigned declare(VarDeclaration *v)
+    {
+        unsigned r = temp();
+        floor = top;
+        *(size_t *)_aaGet(&vars, v) = r + 1;
+        return r;
+    }
+
+    /* Register of local variable v, or -1 if it is not one of ours
+     */
+    int lookup(Declaration *d)
+    {
+        size_t r = (size_t)_aaGetRvalue(vars, d);
+        return (int)r - 1;
+    }
+
+    bool fail()
+    {
+        failed = true;
+        return false;
+    }
+
+    /* Compile e, leaving its value in register result.
+     */
+    bool gen(Expression *e)
+    {
+        if (failed)
+            return false;
+        if (e->type->ty != Tvoid && !isSupported(e->type))
+            return fail();
+        e->accept(this);
+        return !failed;
+    }
+
+    /* Compile e into a register nothing else will write to before
+     * the value is used.
+     */
+    bool genTemp(Expression *e)
+    {
+        if (!gen(e))
+            return false;
+        if (result < floor)
+        {   unsigned r = temp();
+            emit(BCnorm, r, result);
+            result = r;
+        }
+        return true;
+    }
+
+    /* Compile e, which must not be an array.
+     */
+    bool genScalar(Expression *e)
+    {
+        if (normOf(e->type) < 0)
+            return fail();
+        return gen(e);
+    }
+
+    void gen(Statement *s)
+    {
+        if (s && !failed)
+        {
+            s->accept(this);
+            top = floor;
+        }
+    }
+
+    /* The variable e refers to, if we can assign to it
+     */
+    int lvalue(Expression *e)
+    {
+        if (e->op != TOKvar)
+            return -1;
+        return lookup(((VarExp *)e)->var);
+    }
+
+    /* Emit dst = e1 op e2 for integer operation op, the result normalized to type.
+     */
+    void binop(TOK op, unsigned dst, Expression *e1, unsigned r1, Expression *e2, unsigned r2, Type *type)
+    {
+        int norm = normOf(type);
+        bool isunsigned = e1->type->isunsigned() || e2->type->isunsigned();
+        int bcop;
+        switch (op)
+        {
+            case TOKadd:    case TOKaddass: bcop = BCadd;   break;
+            case TOKmin:    case TOKminass: bcop = BCsub;   break;
+            case TOKmul:    case TOKmulass: bcop = BCmul;   break;
+            case TOKand:    case TOKandass: bcop = BCand;   break;
+            case TOKor:     case TOKorass:  bcop = BCor;    break;
+            case TOKxor:    case TOKxorass: bcop = BCxor;   break;
+            case TOKdiv:    case TOKdivass: bcop = isunsigned ? BCdivu : BCdivs;    break;
+            case TOKmod:    case TOKmodass: bcop = isunsigned ? BCmodu : BCmods;    break;
+            case TOKshl:    case TOKshlass: bcop = BCshl;   break;
+            case TOKshr:    case TOKshrass:
+                bcop = e1->type->isunsigned() ? BCshru : BCshrs;
+                break;
+            case TOKushr:   case TOKushrass: bcop = BCushr; break;
+            default:
+                fail();
+                return;
+        }
+        sinteger_t imm = 0;
+        if (bcop == BCshl || bcop == BCshrs || bcop == BCshru || bcop == BCushr)
+        {   // Shifts of bool cannot be folded, and are rejected by semantic anyway
+            if (normOf(e1->type) == NORMbool)
+            {   fail();
+                return;
+            }
+            imm = e1->type->size() * 8;
+        }
+        emit(bcop, dst, r1, r2, imm, norm);
+    }
+
+    /****** Statements ******/
+
+    void visit(Statement *s)
+    {
+#if LOG
+        printf("ctfevm: unsupported statement %s\n", s->toChars());
+#endif
+        fail();
+    }
+
+    void visit(ExpStatement *s)
+    {
+        if (s->exp)
+            gen(s->exp);
+    }
+
+    void visit(DtorExpStatement *s)
+    {
+        fail();
+    }
+
+    void visit(CompoundStatement *s)
+    {
+        for (size_t i = 0; i < s->statements->dim; i++)
+            gen((*s->statements)[i]);
+    }
+
+    void visit(ScopeStatement *s)
+    {
+        gen(s->statement);
+    }
+
+    void visit(IfStatement *s)
+    {
+        if (s->arg || s->match)
+        {   fail();
+            return;
+        }
+        if (!genScalar(s->condition))
+            return;
+        size_t jelse = emit(BCjz, 0, result);
+        top = floor;
+        gen(s->ifbody);
+        if (s->elsebody)
+        {
+            size_t jend = emit(BCjmp);
+            patch(jelse);
+            gen(s->elsebody);
+            patch(jend);
+        }
+        else
+            patch(jelse);
+    }
+
+    void endLoop(BcLoop *l, size_t continueTarget)
+    {
+        for (size_t i = 0; i < l->continues.dim; i++)
+            code[l->continues[i]].imm = continueTarget;
+        for (size_t i = 0; i < l->breaks.dim; i++)
+            patch(l->breaks[i]);
+        loop = l->outer;
+    }
+
+    void visit(ForStatement *s)
+    {
+        gen(s->init);
+        BcLoop l;
+        l.outer = loop;
+        size_t start = code.dim;
+        if (s->condition)
+        {
+            if (!genScalar(s->condition))
+                return;
+            l.breaks.push(emit(BCjz, 0, result));
+            top = floor;
+        }
+        loop = &l;
+        gen(s->body);
+        size_t cont = code.dim;
+        if (s->increment)
+        {
+            gen(s->increment);
+            top = floor;
+        }
+        emit(BCjmp, 0, 0, 0, start);
+        endLoop(&l, cont);
+    }
+
+    void visit(DoStatement *s)
+    {
+        BcLoop l;
+        l.outer = loop;
+        loop = &l;
+        size_t start = code.dim;
+        gen(s->body);
+        size_t cont = code.dim;
+        if (!genScalar(s->condition))
+            return;
+        emit(BCjnz, 0, result, 0, start);
+        endLoop(&l, cont);
+    }
+
+    void visit(BreakStatement *s)
+    {
+        if (s->ident || !loop)
+        {   fail();
+            return;
+        }
+        loop->breaks.push(emit(BCjmp));
+    }
+
+    void visit(ContinueStatement *s)
+    {
+        if (s->ident || !loop)
+        {   fail();
+            return;
+        }
+        loop->continues.push(emit(BCjmp));
+    }
+
+    void visit(ReturnStatement *s)
+    {
+        if (!s->exp || !gen(s->exp))
+        {   fail();
+            return;
+        }
+        retlocs.push(s->exp->loc);
+        emit(BCret, 0, result, 0, retlocs.dim - 1, bf->retnorm);
+    }
+
+    /****** Expressions ******/
+
+    void visit(Expression *e)
+    {
+#if LOG
+        printf("ctfevm: unsupported expression %s\n", e->toChars());
+#endif
+        fail();
+    }
+
+    void visit(IntegerExp *e)
+    {
+        result = temp();
+        emit(BCimm, result, 0, 0, (sinteger_t)e->toInteger());
+    }
+
+    void visit(VarExp *e)
+    {
+        int r = lookup(e->var);
+        if (r < 0)
+        {   fail();
+            return;
+        }
+        result = r;
+    }
+
+    void visit(DeclarationExp *e)
+    {
+        VarDeclaration *v = e->declaration->isVarDeclaration();
+        if (!v || v->toAlias() != v || v->isDataseg() || v->isStatic() ||
+            (v->storage_class & (STCmanifest | STCref | STCout | STClazy)) ||
+            !isSupported(v->type) || !v->init || !v->init->isExpInitializer())
+        {   fail();
+            return;
+        }
+        declare(v);
+        gen(v->init->isExpInitializer()->exp);
+    }
+
+    void visit(CastExp *e)
+    {
+        if (!gen(e->e1))
+            return;
+        if (isScalarArray(e->type) && isScalarArray(e->e1->type) &&
+            normOf(e->type->toBasetype()->nextOf()) == normOf(e->e1->type->toBasetype()->nextOf()))
+        {   // Only the qualifiers change
+            return;
+        }
+        if (normOf(e->e1->type) < 0 || normOf(e->type) < 0)
+        {   fail();
+            return;
+        }
+        unsigned r = temp();
+        emit(BCnorm, r, result, 0, 0, normOf(e->type));
+        result = r;
+    }
+
+    void visit(NegExp *e)
+    {
+        if (!genScalar(e->e1))
+            return;
+        unsigned r = temp();
+        emit(BCneg, r, result, 0, 0, normOf(e->type));
+        result = r;
+    }
+
+    void visit(ComExp *e)
+    {
+        if (!genScalar(e->e1))
+            return;
+        unsigned r = temp();
+        emit(BCcom, r, result, 0, 0, normOf(e->type));
+        result = r;
+    }
+
+    void visit(NotExp *e)
+    {
+        if (!genScalar(e->e1))
+            return;
+        unsigned r = temp();
+        emit(BCnot, r, result);
+        result = r;
+    }
+
+    void visit(BinExp *e)
+    {
+        switch (e->op)
+        {
+            case TOKadd: case TOKmin: case TOKmul: case TOKdiv: case TOKmod:
+            case TOKand: case TOKor: case TOKxor:
+            case TOKshl: case TOKshr: case TOKushr:
+                break;
+            default:
+                fail();
+                return;
+        }
+        if (normOf(e->e1->type) < 0 || normOf(e->e2->type) < 0)
+        {   fail();         // an array operation
+            return;
+        }
+        unsigned r1, r2;
+        if (!(e->e2->hasSideEffect() ? genTemp(e->e1) : gen(e->e1)))
+            return;
+        r1 = result;
+        if (!gen(e->e2))
+            return;
+        r2 = result;
+        result = temp();
+        binop(e->op, result, e->e1, r1, e->e2, r2, e->type);
+    }
+
+    void compare(BinExp *e)
+    {
+        if (normOf(e->e1->type) < 0 || normOf(e->e2->type) < 0)
+        {   fail();
+            return;
+        }
+        bool isunsigned = e->e1->type->isunsigned() || e->e2->type->isunsigned();
+        int bcop;
+        switch (e->op)
+        {
+            case TOKequal:  case TOKidentity:       bcop = BCeq;    break;
+            case TOKnotequal: case TOKnotidentity:  bcop = BCne;    break;
+            case TOKlt:     bcop = isunsigned ? BCltu : BClt;       break;
+            case TOKle:     bcop = isunsigned ? BCleu : BCle;       break;
+            case TOKgt:     bcop = isunsigned ? BCgtu : BCgt;       break;
+            case TOKge:     bcop = isunsigned ? BCgeu : BCge;       break;
+            default:
+                fail();
+                return;
+        }
+        if (!(e->e2->hasSideEffect() ? genTemp(e->e1) : gen(e->e1)))
+            return;
+        unsigned r1 = result;
+        if (!gen(e->e2))
+            return;
+        unsigned r2 = result;
+        result = temp();
+        emit(bcop, result, r1, r2);
+    }
+
+    void visit(CmpExp *e)       { compare(e); }
+    void visit(EqualExp *e)     { compare(e); }
+    void visit(IdentityExp *e)  { compare(e); }
+
+    void logical(BinExp *e, bool isOrOr)
+    {
+        if (normOf(e->type) != NORMbool || !genScalar(e->e1))
+        {   fail();
+            return;
+        }
+        unsigned r = temp();
+        size_t jshort = emit(isOrOr ? BCjnz : BCjz, 0, result);
+        if (!genScalar(e->e2))
+            return;
+        emit(BCbool, r, result);
+        size_t jend = emit(BCjmp);
+        patch(jshort);
+        emit(BCimm, r, 0, 0, isOrOr);
+        patch(jend);
+        result = r;
+    }
+
+    void visit(AndAndExp *e)    { logical(e, false); }
+    void visit(OrOrExp *e)      { logical(e, true); }
+
+    void visit(CondExp *e)
+    {
+        if (!genScalar(e->econd))
+            return;
+        unsigned r = temp();
+        size_t jelse = emit(BCjz, 0, result);
+        if (!gen(e->e1))
+            return;
+        emit(BCnorm, r, result);
+        size_t jend = emit(BCjmp);
+        patch(jelse);
+        if (!gen(e->e2))
+            return;
+        emit(BCnorm, r, result);
+        patch(jend);
+        result = r;
+    }
+
+    void visit(CommaExp *e)
+    {
+        if (gen(e->e1))
+            gen(e->e2);
+    }
+
+    /* Compile the array and index of e into registers.
+     * The interpreter evaluates the right hand side of an assignment
+     * before the left, so side effects in the left are not supported.
+     */
+    bool index(IndexExp *e, unsigned *parr, unsigned *pidx)
+    {
+        if (!isScalarArray(e->e1->type))
+            return fail();
+        if (!(e->e2->hasSideEffect() ? genTemp(e->e1) : gen(e->e1)))
+            return false;
+        *parr = result;
+        if (e->lengthVar)
+            emit(BClen, declare(e->lengthVar), *parr);
+        if (!gen(e->e2))
+            return false;
+        *pidx = result;
+        return true;
+    }
+
+    void visit(IndexExp *e)
+    {
+        unsigned ra, ri;
+        if (!index(e, &ra, &ri))
+            return;
+        result = temp();
+        emit(BCload, result, ra, ri);
+    }
+
+    void visit(SliceExp *e)
+    {
+        if (!isScalarArray(e->e1->type) || !isScalarArray(e->type))
+        {   fail();
+            return;
+        }
+        if (!e->lwr)
+        {   gen(e->e1);
+            return;
+        }
+        bool sideeffect = e->lwr->hasSideEffect() || e->upr->hasSideEffect();
+        if (!(sideeffect ? genTemp(e->e1) : gen(e->e1)))
+            return;
+        unsigned ra = result;
+        if (e->lengthVar)
+            emit(BClen, declare(e->lengthVar), ra);
+        if (!(e->upr->hasSideEffect() ? genTemp(e->lwr) : gen(e->lwr)))
+            return;
+        unsigned rl = result;
+        if (!gen(e->upr))
+            return;
+        unsigned ru = result;
+        result = temp();
+        emit(BCslice, result, ra, rl, ru);
+    }
+
+    void visit(ArrayLengthExp *e)
+    {
+        if (!isScalarArray(e->e1->type) || !gen(e->e1))
+        {   fail();
+            return;
+        }
+        unsigned r = temp();
+        emit(BClen, r, result);
+        result = r;
+    }
+
+    void visit(NullExp *e)
+    {
+        result = temp();
+        emit(BCimm, result, 0, 0, 0);
+    }
+
+    void visit(StringExp *e)
+    {
+        int norm = normOf(e->type->toBasetype()->nextOf());
+        if (elemSize(norm) != e->sz)
+        {   fail();
+            return;
+        }
+        // Part of the code, so it must outlive the CTFE region
+        BcBuffer *b = (BcBuffer *)mem.allocate(MEMother, sizeof(BcBuffer));
+        b->data = (unsigned char *)e->string;
+        b->dim = e->len;
+        b->norm = (unsigned char)norm;
+        b->flags = BUFreadonly | BUFstring | (e->committed ? BUFcommitted : 0);
+        BcSlice *s = (BcSlice *)mem.allocate(MEMother, sizeof(BcSlice));
+        s->buf = b;
+        s->lwr = 0;
+        s->length = e->len;
+        result = temp();
+        emit(BCimm, result, 0, 0, fromSlice(s));
+    }
+
+    /* Compile the n expressions into consecutive registers,
+     * returning the first.
+     */
+    unsigned genList(Expressions *exps)
+    {
+        size_t n = exps ? exps->dim : 0;
+        unsigned base = top;
+        top += n;
+        if (top > bf->nregs)
+            bf->nregs = top;
+        for (size_t i = 0; i < n; i++)
+        {
+            Expression *ex = (*exps)[i];
+            if (!gen(ex))
+                break;
+            emit(BCnorm, base + i, result, 0, 0, regNorm(ex->type));
+        }
+        return base;
+    }
+
+    void visit(ArrayLiteralExp *e)
+    {
+        unsigned base = genList(e->elements);
+        result = temp();
+        emit(BCarrlit, result, base, e->elements->dim, 0, normOf(e->type->toBasetype()->nextOf()));
+    }
+
+    void visit(NewExp *e)
+    {
+        Type *tb = e->newtype->toBasetype();
+        if (tb->ty != Tarray || !isScalarArray(tb) || !e->arguments ||
+            e->arguments->dim != 1 || e->thisexp || e->newargs || !gen((*e->arguments)[0]))
+        {   fail();
+            return;
+        }
+        Type *telem = ((TypeArray *)tb)->next;
+        unsigned r = temp();
+        emit(BCnewarr, r, result, newArrayFlags(telem),
+            telem->defaultInitLiteral(e->loc)->toInteger(), normOf(telem));
+        result = r;
+    }
+
+    void visit(AssignExp *e)
+    {
+        if (e->e1->hasSideEffect())
+        {   fail();
+            return;
+        }
+        switch (e->e1->op)
+        {
+            case TOKvar:
+            {
+                int v = lvalue(e->e1);
+                if (v < 0 || !gen(e->e2))
+                    break;
+                emit(BCnorm, v, result, 0, 0, regNorm(e->e1->type));
+                result = v;
+                return;
+            }
+            case TOKindex:
+            {
+                if (!gen(e->e2))
+                    break;
+                unsigned rv = result;
+                unsigned ra, ri;
+                if (!index((IndexExp *)e->e1, &ra, &ri))
+                    break;
+                emit(BCstore, ra, ri, rv);
+                result = rv;
+                return;
+            }
+            case TOKarraylength:
+            {
+                ArrayLengthExp *ale = (ArrayLengthExp *)e->e1;
+                int v = lvalue(ale->e1);
+                if (v < 0 || !isScalarArray(ale->e1->type) || !gen(e->e2))
+                    break;
+                Type *telem = ale->e1->type->toBasetype()->nextOf();
+                emit(BCsetlen, v, v, result, telem->defaultInitLiteral(e->loc)->toInteger(), normOf(telem));
+                return;         // the value is the new length, still in result
+            }
+            case TOKslice:
+            {
+                if (!gen(e->e2))
+                    break;
+                unsigned rv = result;
+                if (!gen(e->e1))
+                    break;
+                emit(isScalarArray(e->e2->type) ? BCblit : BCfill, result, rv);
+                return;
+            }
+            default:
+                break;
+        }
+        fail();
+    }
+
+    /* Compile the read-modify-write of e1 op= e2, or e1++ if result is
+     * to be the old value.
+     */
+    void modify(BinExp *e, TOK op, bool post)
+    {
+        if (normOf(e->e1->type) < 0 || (normOf(e->e1->type) == NORMbool && post) ||
+            e->e1->hasSideEffect() || !gen(e->e2))
+        {   fail();
+            return;
+        }
+        unsigned r2 = result;
+        if (e->e1->op == TOKvar)
+        {
+            int v = lvalue(e->e1);
+            if (v < 0)
+            {   fail();
+                return;
+            }
+            unsigned old = 0;
+            if (post)
+            {   old = temp();
+                emit(BCnorm, old, v);
+            }
+            binop(op, v, e->e1, v, e->e2, r2, e->e1->type);
+            result = post ? old : v;
+        }
+        else if (e->e1->op == TOKindex)
+        {
+            unsigned ra, ri;
+            if (!index((IndexExp *)e->e1, &ra, &ri))
+                return;
+            unsigned old = temp();
+            emit(BCload, old, ra, ri);
+            unsigned v = temp();
+            binop(op, v, e->e1, old, e->e2, r2, e->e1->type);
+            emit(BCstore, ra, ri, v);
+            result = post ? old : v;
+        }
+        else
+            fail();
+    }
+
+    void visit(BinAssignExp *e)
+    {
+        modify(e, e->op, false);
+    }
+
+    void visit(PostExp *e)
+    {
+        modify(e, e->op == TOKplusplus ? TOKadd : TOKmin, true);
+    }
+
+    void visit(CallExp *e)
+    {
+        if (e->e1->op != TOKvar)
+        {   fail();
+            return;
+        }
+        FuncDeclaration *fd = ((VarExp *)e->e1)->var->isFuncDeclaration();
+        if (!fd || (e->e1->type && e->e1->type->ty == Tdelegate))
+        {   fail();
+            return;
+        }
+        size_t nargs = e->arguments ? e->arguments->dim : 0;
+        unsigned base = genList(e->arguments);
+        size_t icallee = bf->callees.dim;
+        bf->callees.push(fd);
+        result = temp();
+        emit(BCcall, result, base, nargs, icallee);
+    }
+
+    void visit(AssertExp *e)
+    {
+        if (!genScalar(e->e1))
+            return;
+        emit(BCassert, 0, result);
+    }
+
+    void visit(HaltExp *e)
+    {
+        emit(BCabort);
+    }
+};
+
+/*************************************
+ * Compile fd to bytecode.
+ * Returns NULL if the VM cannot run it.
+ */
+
+BcFunction *bcCompile(FuncDeclaration *fd)
+{
+    if (fd->ctfeBc)
+        return fd->ctfeBc->ok ? fd->ctfeBc : NULL;
+
+    BcFunction *bf = new BcFunction(fd);
+    fd->ctfeBc = bf;
+
+    Type *tb = fd->type->toBasetype();
+    if (tb->ty != Tfunction)
+        return NULL;
+    TypeFunction *tf = (TypeFunction *)tb;
+    if (!fd->fbody || fd->isNested() || fd->needThis() || fd->vresult ||
+        tf->varargs || tf->isref || !tf->next || !isSupported(tf->next) ||
+        fd->isBuiltin() != BUILTINno)
+        return NULL;
+
+    BcCompiler bc(bf);
+    bf->tret = tf->next;
+    bf->retnorm = (unsigned char)regNorm(tf->next);
+
+    size_t nparams = fd->parameters ? fd->parameters->dim : 0;
+    if (nparams != Parameter::dim(tf->parameters))
+        return NULL;
+    bf->nparams = (unsigned)nparams;
+    bf->paramnorm = (unsigned char *)mem.malloc(nparams + 1);
+    for (size_t i = 0; i < nparams; i++)
+    {
+        VarDeclaration *v = (*fd->parameters)[i];
+        Parameter *p = Parameter::getNth(tf->parameters, i);
+        if (!isSupported(v->type) || (p->storageClass & (STCref | STCout | STClazy)))
+            return NULL;
+        bf->paramnorm[i] = (unsigned char)regNorm(v->type);
+        bc.declare(v);
+    }
+
+    bc.gen(fd->fbody);
+    if (bc.failed)
+    {
+#if LOG
+        printf("ctfevm: %s not compiled\n", fd->toPrettyChars());
+#endif
+        return NULL;
+    }
+    bc.emit(BCabort);                   // fell off the end
+    if (!bf->nregs)
+        bf->nregs = 1;                  // instructions always read a register
+
+    bf->codedim = bc.code.dim;
+    bf->code = (BcInstr *)mem.malloc(bf->codedim * sizeof(BcInstr));
+    memcpy(bf->code, bc.code.tdata(), bf->codedim * sizeof(BcInstr));
+    bf->retlocs = (Loc *)mem.malloc((bc.retlocs.dim + 1) * sizeof(Loc));
+    for (size_t i = 0; i < bc.retlocs.dim; i++)
+        bf->retlocs[i] = bc.retlocs[i];
+
+    /* A strongly pure function of integers always returns the same
+     * value for the same arguments, so the VM can reuse the results
+     * of earlier calls, like the interpreter does.
+     */
+    if (global.params.ctfeMemo && fd->isPure() == PUREstrong && !isScalarArray(tf->next))
+    {
+        bf->memoizable = true;
+        for (size_t i = 0; i < nparams; i++)
+        {
+            if (isScalarArray((*fd->parameters)[i]->type))
+                bf->memoizable = false;
+        }
+    }
+    bf->ok = true;
+#if LOG
+    printf("ctfevm: %s compiled, %d instructions, %d registers\n",
+        fd->toPrettyChars(), (int)bf->codedim, bf->nregs);
+#endif
+    return bf;
+}
+
+/************************************
+ * Virtual machine.
+ */
+
+// Register file shared by all frames, addressed by offset as it may move
+static sinteger_t *vmstack;
+static size_t vmstackdim;
+static size_t vmtop;            // end of the live frames, where a nested bcRun() starts
+
+static void reserve(size_t dim)
+{
+    if (dim > vmstackdim)
+    {
+        vmstackdim = dim * 2;
+        vmstack = (sinteger_t *)mem.realloc(vmstack, vmstackdim * sizeof(sinteger_t));
+    }
+}
+
+static hash_t memoHash(sinteger_t *args, unsigned nargs)
+{
+    hash_t h = 0;
+    for (unsigned i = 0; i < nargs; i++)
+        h = h * 31 + (hash_t)args[i];
+    return h;
+}
+
+static BcMemo *memoLookup(BcFunction *bf, sinteger_t *args, hash_t h)
+{
+    for (BcMemo *m = (BcMemo *)_aaGetRvalue(bf->memo, (void *)h); m; m = m->next)
+    {
+        if (memcmp(m->args, args, bf->nparams * sizeof(sinteger_t)) == 0)
+            return m;
+    }
+    return NULL;
+}
+
+/* Entry for a call with arguments args, to be filled in by memoStore()
+ * once the call returns, as the callee may change its parameters.
+ */
+static BcMemo *memoNew(BcFunction *bf, sinteger_t *args)
+{
+    BcMemo *m = (BcMemo *)mem.malloc(sizeof(BcMemo) + bf->nparams * sizeof(sinteger_t));
+    memcpy(m->args, args, bf->nparams * sizeof(sinteger_t));
+    return m;
+}
+
+static void memoStore(BcFunction *bf, BcMemo *m, hash_t h, sinteger_t result)
+{
+    CtfeStatus::numMemoMisses++;
+    m->result = result;
+    BcMemo **pm = (BcMemo **)_aaGet(&bf->memo, (void *)h);
+    m->next = *pm;
+    *pm = m;
+}
+
+/* Returns false if the VM gave up.
+ */
+static bool execute(BcFunction *bf, size_t base, int depth, sinteger_t *presult, size_t *pretloc)
+{
+    if (depth + CtfeStatus::callDepth > CTFE_RECURSION_LIMIT)
+        return false;
+
+    sinteger_t *r = vmstack + base;
+    BcInstr *code = bf->code;
+    size_t pc = 0;
+    while (1)
+    {
+        BcInstr *in = &code[pc++];
+        sinteger_t a = r[in->a];
+        sinteger_t b = r[in->b];
+        switch (in->op)
+        {
+            case BCimm:     r[in->dst] = in->imm;                            break;
+            case BCnorm:    r[in->dst] = normalize(a, in->norm);             break;
+            case BCadd:     r[in->dst] = normalize((d_uns64)a + (d_uns64)b, in->norm);  break;
+            case BCsub:     r[in->dst] = normalize((d_uns64)a - (d_uns64)b, in->norm);  break;
+            case BCmul:     r[in->dst] = normalize((d_uns64)a * (d_uns64)b, in->norm);  break;
+            case BCand:     r[in->dst] = normalize(a & b, in->norm);         break;
+            case BCor:      r[in->dst] = normalize(a | b, in->norm);         break;
+            case BCxor:     r[in->dst] = normalize(a ^ b, in->norm);         break;
+
+            case BCdivs:
+            case BCdivu:
+            case BCmods:
+            case BCmodu:
+                // Leave division by 0 and int.min % -1 to the interpreter to diagnose
+                if (b == 0 || (b == -1 && (a == (sinteger_t)0x8000000000000000LL || a == (d_int32)0x80000000)))
+                    return false;
+                switch (in->op)
+                {
+                    case BCdivs:    a = a / b;                      break;
+                    case BCdivu:    a = (d_uns64)a / (d_uns64)b;    break;
+                    case BCmods:    a = a % b;                      break;
+                    case BCmodu:    a = (d_uns64)a % (d_uns64)b;    break;
+                }
+                r[in->dst] = normalize(a, in->norm);
+                break;
+
+            case BCshl:
+            case BCshrs:
+            case BCshru:
+            case BCushr:
+                if (b < 0 || b >= in->imm)
+                    return false;
+                switch (in->op)
+                {
+                    case BCshl:     a = (d_uns64)a << b;            break;
+                    case BCshrs:    a = a >> b;                     break;
+                    case BCshru:    a = (d_uns64)a >> b;            break;
+                    case BCushr:
+                        if (in->imm < 64)
+                            a &= ((d_uns64)1 << in->imm) - 1;
+                        a = (d_uns64)a >> b;
+                        break;
+                }
+                r[in->dst] = normalize(a, in->norm);
+                break;
+
+            case BCneg:     r[in->dst] = normalize(-(d_uns64)a, in->norm);   break;
+            case BCcom:     r[in->dst] = normalize(~a, in->norm);            break;
+            case BCnot:     r[in->dst] = a == 0;                             break;
+            case BCbool:    r[in->dst] = a != 0;                             break;
+
+            case BCeq:      r[in->dst] = a == b;                             break;
+            case BCne:      r[in->dst] = a != b;                             break;
+            case BClt:      r[in->dst] = a < b;                              break;
+            case BCle:      r[in->dst] = a <= b;                             break;
+            case BCgt:      r[in->dst] = a > b;                              break;
+            case BCge:      r[in->dst] = a >= b;                             break;
+            case BCltu:     r[in->dst] = (d_uns64)a <  (d_uns64)b;           break;
+            case BCleu:     r[in->dst] = (d_uns64)a <= (d_uns64)b;           break;
+            case BCgtu:     r[in->dst] = (d_uns64)a >  (d_uns64)b;           break;
+            case BCgeu:     r[in->dst] = (d_uns64)a >= (d_uns64)b;           break;
+
+            case BCnewarr:
+            {
+                if ((d_uns64)a > 0x7FFFFFFF)
+                    return false;               // leave it to the interpreter to run out of memory
+                BcBuffer *buf = newBuffer((size_t)a, in->norm, in->b);
+                for (size_t i = 0; i < (size_t)a; i++)
+                    setElem(buf, i, in->imm);
+                r[in->dst] = fromSlice(newSlice(buf, 0, (size_t)a));
+                break;
+            }
+
+            case BCarrlit:
+            {
+                BcBuffer *buf = newBuffer(in->b, in->norm, (int)in->imm);
+                for (unsigned i = 0; i < in->b; i++)
+                    setElem(buf, i, r[in->a + i]);
+                r[in->dst] = fromSlice(newSlice(buf, 0, in->b));
+                break;
+            }
+
+            case BClen:
+                r[in->dst] = a ? toSlice(a)->length : 0;
+                break;
+
+            case BCsetlen:
+            {
+                BcSlice *s = toSlice(a);
+                size_t oldlen = s ? s->length : 0;
+                size_t newlen = (size_t)b;
+                if ((d_uns64)b > 0x7FFFFFFF)
+                    return false;
+                if (newlen == oldlen)
+                    break;
+                /* Like changeArrayLiteralLength(), always copy. Strings stay
+                 * strings, unless they were empty.
+                 */
+                int flags = 0;
+                if (oldlen && (s->buf->flags & BUFstring))
+                {
+                    if (s->lwr && newlen > oldlen)
+                        return false;
+                    flags = s->buf->flags & (BUFstring | BUFcommitted);
+                }
+                BcBuffer *buf = newBuffer(newlen, in->norm, flags);
+                size_t copylen = oldlen < newlen ? oldlen : newlen;
+                if (copylen)
+                    memcpy(buf->data, s->buf->data + s->lwr * elemSize(buf->norm), copylen * elemSize(buf->norm));
+                for (size_t i = copylen; i < newlen; i++)
+                    setElem(buf, i, in->imm);
+                r[in->dst] = fromSlice(newSlice(buf, 0, newlen));
+                break;
+            }
+
+            case BCload:
+            {
+                BcSlice *s = toSlice(a);
+                if (!s || (d_uns64)b >= s->length)
+                    return false;
+                r[in->dst] = getElem(s->buf, s->lwr + (size_t)b);
+                break;
+            }
+
+            case BCstore:
+            {
+                BcSlice *s = toSlice(r[in->dst]);
+                if (!s || (d_uns64)a >= s->length || (s->buf->flags & BUFreadonly))
+                    return false;
+                setElem(s->buf, s->lwr + (size_t)a, b);
+                break;
+            }
+
+            case BCslice:
+            {
+                BcSlice *s = toSlice(a);
+                d_uns64 upr = r[in->imm];
+                if ((d_uns64)b > upr || upr > (s ? s->length : 0))
+                    return false;
+                r[in->dst] = s ? fromSlice(newSlice(s->buf, s->lwr + (size_t)b, (size_t)(upr - b))) : 0;
+                break;
+            }
+
+            case BCblit:
+            {
+                BcSlice *d = toSlice(r[in->dst]);
+                BcSlice *s = toSlice(a);
+                size_t len = d ? d->length : 0;
+                if (len != (s ? s->length : 0))
+                    return false;
+                if (!len)
+                    break;
+                if ((d->buf->flags & BUFreadonly) ||
+                    (d->buf->data == s->buf->data &&
+                     d->lwr < s->lwr + len && s->lwr < d->lwr + len))
+                    return false;               // the interpreter reports overlapping copies
+                size_t sz = elemSize(d->buf->norm);
+                memcpy(d->buf->data + d->lwr * sz, s->buf->data + s->lwr * sz, len * sz);
+                break;
+            }
+
+            case BCfill:
+            {
+                BcSlice *d = toSlice(r[in->dst]);
+                if (!d)
+                    break;
+                if (d->buf->flags & BUFreadonly)
+                    return false;
+                for (size_t i = 0; i < d->length; i++)
+                    setElem(d->buf, d->lwr + i, a);
+                break;
+            }
+
+            case BCjmp:     pc = (size_t)in->imm;                            break;
+            case BCjz:      if (!a) pc = (size_t)in->imm;                    break;
+            case BCjnz:     if (a) pc = (size_t)in->imm;                     break;
+
+            case BCcall:
+            {
+                size_t cbase = base + bf->nregs;
+                size_t savetop = vmtop;
+                vmtop = cbase;          // bcFunction() may run CTFE, which must not touch this frame
+                FuncDeclaration *fd = bf->callees[(size_t)in->imm];
+                BcFunction *callee = bcFunction(fd);
+                if (!callee || callee->nparams != in->b)
+                {
+                    /* Unless fd is only waiting for its semantic analysis
+                     * to finish, it will never run in the VM. Then neither
+                     * will bf, so don't start it only to give up here again.
+                     */
+                    if (fd->semanticRun != PASSsemantic3)
+                        bf->ok = false;
+                    return false;
+                }
+                reserve(cbase + callee->nregs);
+                r = vmstack + base;
+                for (unsigned i = 0; i < in->b; i++)
+                    vmstack[cbase + i] = normalize(r[in->a + i], callee->paramnorm[i]);
+                hash_t h = 0;
+                BcMemo *m = NULL;
+                if (callee->memoizable)
+                {
+                    h = memoHash(vmstack + cbase, callee->nparams);
+                    m = memoLookup(callee, vmstack + cbase, h);
+                    if (m)
+                    {
+                        CtfeStatus::numMemoHits++;
+                        vmtop = savetop;
+                        r[in->dst] = m->result;
+                        break;
+                    }
+                    m = memoNew(callee, vmstack + cbase);
+                }
+                sinteger_t v;
+                size_t retloc;
+                if (!execute(callee, cbase, depth + 1, &v, &retloc))
+                {
+                    mem.free(m);
+                    return false;
+                }
+                if (m)
+                    memoStore(callee, m, h, v);
+                vmtop = savetop;
+                r = vmstack + base;
+                r[in->dst] = v;
+                break;
+            }
+
+            case BCret:
+                *presult = normalize(a, in->norm);
+                *pretloc = (size_t)in->imm;
+                return true;
+
+            case BCassert:
+                if (!a)
+                    return false;
+                break;
+
+            case BCabort:
+                return false;
+
+            default:
+                assert(0);
+        }
+    }
+}
+
+/*************************************
+ * The bytecode for fd, compiling it if necessary, after the same checks
+ * the interpreter does before calling a function.
+ * Returns NULL if the VM cannot run fd.
+ */
+
+BcFunction *bcFunction(FuncDeclaration *fd)
+{
+    if (fd->ctfeBc)
+        return fd->ctfeBc->ok ? fd->ctfeBc : NULL;
+    if (fd->semanticRun == PASSsemantic3 || !fd->functionSemantic3() ||
+        fd->semanticRun < PASSsemantic3done || fd->semantic3Errors)
+        return NULL;
+    return bcCompile(fd);
+}
+
+/*************************************
+ * Convert the interpreter's value e of array type t for the VM.
+ * Only arrays the function cannot write to are accepted, as changes
+ * would not make it back to the interpreter.
+ */
+
+static bool importArray(Expression *e, Type *t, sinteger_t *pv)
+{
+    Type *telem = t->toBasetype()->nextOf();
+    if (telem->isMutable())
+        return false;
+    int norm = normOf(telem);
+    size_t sz = elemSize(norm);
+    int flags = BUFreadonly | (telem->isImmutable() ? 0 : BUFmutable);
+
+    if (e->op == TOKnull)
+    {   *pv = 0;
+        return true;
+    }
+    bool whole = true;
+    size_t lwr = 0;
+    size_t upr = 0;
+    if (e->op == TOKslice)
+    {
+        SliceExp *se = (SliceExp *)e;
+        if (!se->lwr || se->lwr->op != TOKint64 || se->upr->op != TOKint64)
+            return false;
+        lwr = (size_t)se->lwr->toInteger();
+        upr = (size_t)se->upr->toInteger();
+        whole = false;
+        e = se->e1;
+    }
+
+    BcBuffer *b;
+    if (e->op == TOKstring)
+    {
+        StringExp *se = (StringExp *)e;
+        if (se->sz != sz)
+            return false;
+        if (whole)
+            upr = se->len;
+        if (lwr > upr || upr > se->len)
+            return false;
+        // Read only, so the data need not be copied
+        b = (BcBuffer *)mem.allocate(MEMctfe, sizeof(BcBuffer));
+        b->data = (unsigned char *)se->string + lwr * sz;
+        b->dim = upr - lwr;
+        b->norm = (unsigned char)norm;
+        b->flags = (unsigned char)(flags | BUFstring | (se->committed ? BUFcommitted : 0));
+    }
+    else if (e->op == TOKarrayliteral)
+    {
+        ArrayLiteralExp *ae = (ArrayLiteralExp *)e;
+        if (whole)
+            upr = ae->elements->dim;
+        if (lwr > upr || upr > ae->elements->dim)
+            return false;
+        b = newBuffer(upr - lwr, norm, flags);
+        for (size_t i = lwr; i < upr; i++)
+        {
+            Expression *el = (*ae->elements)[i];
+            if (el->op != TOKint64)
+                return false;
+            setElem(b, i - lwr, el->toInteger());
+        }
+    }
+    else
+        return false;
+    *pv = fromSlice(newSlice(b, 0, b->dim));
+    return true;
+}
+
+/*************************************
+ * Convert the VM's array s to the literal the interpreter would have,
+ * or return NULL if it is (part of) one the interpreter still has.
+ */
+
+static Expression *exportArray(Loc loc, BcSlice *s, Type *t)
+{
+    if (!s)
+        return new NullExp(loc, t);
+    BcBuffer *b = s->buf;
+    if (b->flags & BUFmutable)
+        return NULL;
+    Expression *e;
+    if (b->flags & BUFstring)
+    {
+        size_t sz = elemSize(b->norm);
+        unsigned char *p = (unsigned char *)allocCtfeString(s->length, sz);
+        memcpy(p, b->data + s->lwr * sz, s->length * sz);
+        StringExp *se = new StringExp(loc, p, s->length);
+        se->sz = (unsigned char)sz;
+        se->committed = (b->flags & BUFcommitted) != 0;
+        se->ownedByCtfe = !(b->flags & BUFreadonly);
+        e = se;
+    }
+    else
+    {
+        Type *telem = t->toBasetype()->nextOf();
+        Expressions *elements = new Expressions();
+        elements->setDim(s->length);
+        for (size_t i = 0; i < s->length; i++)
+            (*elements)[i] = new IntegerExp(loc, getElem(b, s->lwr + i), telem);
+        ArrayLiteralExp *ae = new ArrayLiteralExp(loc, elements);
+        ae->ownedByCtfe = !(b->flags & BUFreadonly);
+        e = ae;
+    }
+    e->type = t;
+    return e;
+}
+
+/*************************************
+ * Run bf with arguments eargs, which must all be integer or
+ * array literals.
+ * Returns the result, or NULL if the VM gave up and the call
+ * needs to be interpreted.
+ */
+
+Expression *bcRun(BcFunction *bf, Expressions *eargs)
+{
+    size_t nargs = eargs ? eargs->dim : 0;
+    if (nargs != bf->nparams)
+        return NULL;
+    /* Start above any frames still live, as this may be a compile
+     * time evaluation nested in a call the VM is making.
+     */
+    size_t base = vmtop;
+    reserve(base + bf->nregs);
+    for (size_t i = 0; i < nargs; i++)
+    {
+        Expression *e = (*eargs)[i];
+        Type *t = (*bf->fd->parameters)[i]->type;
+        sinteger_t v;
+        if (isScalarArray(t))
+        {
+            if (!importArray(e, t, &v))
+                return NULL;
+        }
+        else if (e->op == TOKint64)
+            v = normalize(e->toInteger(), bf->paramnorm[i]);
+        else
+            return NULL;
+        vmstack[base + i] = v;
+    }
+
+    CtfeStatus::numBcCalls++;
+    sinteger_t v;
+    size_t retloc;
+    Expression *e = NULL;
+    bool ok = execute(bf, base, 1, &v, &retloc);
+    vmtop = base;
+    if (ok)
+    {
+        Loc loc = bf->retlocs[retloc];
+        if (isScalarArray(bf->tret))
+            e = exportArray(loc, toSlice(v), bf->tret);
+        else
+            e = new IntegerExp(loc, v, bf->tret);
+    }
+    if (!e)
+        CtfeStatus::numBcAborts++;
+    return e;
+}
@@ -1919,6 +1919,7 @@ Expression *VarDeclaration::getConstInitializer(bool needFullType)
 
     if (scope)
     {
+        CtfeRegionSuspend crs;
         inuse++;
         init = init->semantic(scope, type, INITinterpret);
         scope = NULL;
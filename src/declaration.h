@@ -32,6 +32,7 @@ class StructDeclaration;
 struct InterState;
 struct IRState;
 struct CompiledCtfeFunction;
+struct BcFunction;
 
 enum PROT;
 enum LINK;
@@ -596,6 +597,7 @@ public:
     ILS inlineStatusExp;
 
     CompiledCtfeFunction *ctfeCode;     // Compiled code for interpreter
+    BcFunction *ctfeBc;                 // Bytecode for the CTFE VM
     int inlineNest;                     // !=0 if nested inline
     bool isArrayOp;                     // true if array operation
     FuncDeclaration *dArrayOp;          // D version of array op for ctfe
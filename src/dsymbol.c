@@ -38,6 +38,11 @@ const char* Pprotectionnames[] = {NULL, "none", "private", "package", "protected
 
 /****************************** Dsymbol ******************************/
 
+void *Dsymbol::operator new(size_t size)
+{
+    return mem.allocate(MEMdsymbol, size);
+}
+
 Dsymbol::Dsymbol()
 {
     //printf("Dsymbol::Dsymbol(%p)\n", this);
@@ -864,6 +869,7 @@ ScopeDsymbol::ScopeDsymbol()
     symtab = NULL;
     imports = NULL;
     prots = NULL;
+    searchCache = NULL;
 }
 
 ScopeDsymbol::ScopeDsymbol(Identifier *id)
@@ -873,6 +879,7 @@ ScopeDsymbol::ScopeDsymbol(Identifier *id)
     symtab = NULL;
     imports = NULL;
     prots = NULL;
+    searchCache = NULL;
 }
 
 Dsymbol *ScopeDsymbol::syntaxCopy(Dsymbol *s)
@@ -893,6 +900,20 @@ Dsymbol *ScopeDsymbol::syntaxCopy(Dsymbol *s)
  * Be very, very careful about slowing it down.
  */
 
+/* The result of searching a scope's imports for an identifier.
+ * It stands until anything that can be imported changes.
+ */
+
+struct SearchCache
+{
+    SearchCache *next;          // for the other flags
+    int flags;
+    unsigned generation;        // searchGeneration it was found at
+    Dsymbol *s;
+};
+
+unsigned ScopeDsymbol::searchGeneration = 0;
+
 Dsymbol *ScopeDsymbol::search(Loc loc, Identifier *ident, int flags)
 {
     //printf("%s->ScopeDsymbol::search(ident='%s', flags=x%x)\n", toChars(), ident->toChars(), flags);
@@ -910,116 +931,168 @@ Dsymbol *ScopeDsymbol::search(Loc loc, Identifier *ident, int flags)
         return NULL;
     else
     {
-        Dsymbol *s = NULL;
-        OverloadSet *a = NULL;
+        SearchCache *c = (SearchCache *)_aaGetRvalue(searchCache, ident);
+        for (; c; c = c->next)
+        {
+            if (c->flags == flags)
+            {
+                if (c->generation == searchGeneration)
+                    return c->s;
+                break;
+            }
+        }
+
+        unsigned generation = searchGeneration;
+        unsigned errors = global.errors + global.gaggedErrors;
+
+        /* A module that is being searched already is skipped, so any
+         * search it is skipped in, down from where it was started, is
+         * incomplete. Our depth is that of Module::search() for a
+         * module, and one more than the current one otherwise.
+         */
+        unsigned depth = Module::searchDepth + (isModule() ? 0 : 1);
+        unsigned cutoff = Module::searchCutoff;
+        Module::searchCutoff = ~0u;
 
-        // Look in imported modules
-        for (size_t i = 0; i < imports->dim; i++)
+        Dsymbol *s = searchImports(loc, ident, flags);
+
+        bool complete = Module::searchCutoff >= depth;
+        if (Module::searchCutoff > cutoff)
+            Module::searchCutoff = cutoff;
+
+        // Only keep answers that were complete and quietly found
+        if (complete && errors == global.errors + global.gaggedErrors)
         {
-            // If private import, don't search it
-            if ((flags & IgnorePrivateMembers) && prots[i] == PROTprivate)
-                continue;
+            if (!c)
+            {
+                SearchCache **pc = (SearchCache **)_aaGet(&searchCache, ident);
+                c = new SearchCache();
+                c->next = *pc;
+                c->flags = flags;
+                *pc = c;
+            }
+            c->generation = generation;
+            c->s = s;
+        }
+        return s;
+    }
+}
 
-            Dsymbol *ss = (*imports)[i];
+/*****************************************
+ * Search the imports for ident.
+ */
 
-            //printf("\tscanning import '%s', prots = %d, isModule = %p, isImport = %p\n", ss->toChars(), prots[i], ss->isModule(), ss->isImport());
-            /* Don't find private members if ss is a module
-             */
-            Dsymbol *s2 = ss->search(loc, ident, ss->isModule() ? IgnorePrivateMembers : IgnoreNone);
-            if (!s)
-                s = s2;
-            else if (s2 && s != s2)
+Dsymbol *ScopeDsymbol::searchImports(Loc loc, Identifier *ident, int flags)
+{
+    Dsymbol *s = NULL;
+    OverloadSet *a = NULL;
+
+    // Look in imported modules
+    for (size_t i = 0; i < imports->dim; i++)
+    {
+        // If private import, don't search it
+        if ((flags & IgnorePrivateMembers) && prots[i] == PROTprivate)
+            continue;
+
+        Dsymbol *ss = (*imports)[i];
+
+        //printf("\tscanning import '%s', prots = %d, isModule = %p, isImport = %p\n", ss->toChars(), prots[i], ss->isModule(), ss->isImport());
+        /* Don't find private members if ss is a module
+         */
+        Dsymbol *s2 = ss->search(loc, ident, ss->isModule() ? IgnorePrivateMembers : IgnoreNone);
+        if (!s)
+            s = s2;
+        else if (s2 && s != s2)
+        {
+            if (s->toAlias() == s2->toAlias() ||
+                s->getType() == s2->getType() && s->getType())
             {
-                if (s->toAlias() == s2->toAlias() ||
-                    s->getType() == s2->getType() && s->getType())
+                /* After following aliases, we found the same
+                 * symbol, so it's not an ambiguity.  But if one
+                 * alias is deprecated or less accessible, prefer
+                 * the other.
+                 */
+                if (s->isDeprecated() ||
+                    s2->prot() > s->prot() && s2->prot() != PROTnone)
+                    s = s2;
+            }
+            else
+            {
+                /* Two imports of the same module should be regarded as
+                 * the same.
+                 */
+                Import *i1 = s->isImport();
+                Import *i2 = s2->isImport();
+                if (!(i1 && i2 &&
+                      (i1->mod == i2->mod ||
+                       (!i1->parent->isImport() && !i2->parent->isImport() &&
+                        i1->ident->equals(i2->ident))
+                      )
+                     )
+                   )
                 {
-                    /* After following aliases, we found the same
-                     * symbol, so it's not an ambiguity.  But if one
-                     * alias is deprecated or less accessible, prefer
-                     * the other.
+                    /* Bugzilla 8668:
+                     * Public selective import adds AliasDeclaration in module.
+                     * To make an overload set, resolve aliases in here and
+                     * get actual overload roots which accessible via s and s2.
                      */
-                    if (s->isDeprecated() ||
-                        s2->prot() > s->prot() && s2->prot() != PROTnone)
-                        s = s2;
-                }
-                else
-                {
-                    /* Two imports of the same module should be regarded as
-                     * the same.
+                    s = s->toAlias();
+                    s2 = s2->toAlias();
+
+                    /* If both s2 and s are overloadable (though we only
+                     * need to check s once)
                      */
-                    Import *i1 = s->isImport();
-                    Import *i2 = s2->isImport();
-                    if (!(i1 && i2 &&
-                          (i1->mod == i2->mod ||
-                           (!i1->parent->isImport() && !i2->parent->isImport() &&
-                            i1->ident->equals(i2->ident))
-                          )
-                         )
-                       )
+                    if (s2->isOverloadable() && (a || s->isOverloadable()))
                     {
-                        /* Bugzilla 8668:
-                         * Public selective import adds AliasDeclaration in module.
-                         * To make an overload set, resolve aliases in here and
-                         * get actual overload roots which accessible via s and s2.
-                         */
-                        s = s->toAlias();
-                        s2 = s2->toAlias();
-
-                        /* If both s2 and s are overloadable (though we only
-                         * need to check s once)
+                        if (!a)
+                        {
+                            a = new OverloadSet(s->ident);
+                            a->parent = this;
+                        }
+                        /* Don't add to a[] if s2 is alias of previous sym
                          */
-                        if (s2->isOverloadable() && (a || s->isOverloadable()))
+                        for (size_t j = 0; j < a->a.dim; j++)
                         {
-                            if (!a)
+                            Dsymbol *s3 = a->a[j];
+                            if (s2->toAlias() == s3->toAlias())
                             {
-                                a = new OverloadSet(s->ident);
-                                a->parent = this;
+                                if (s3->isDeprecated() ||
+                                    s2->prot() > s3->prot() && s2->prot() != PROTnone)
+                                    a->a[j] = s2;
+                                goto Lcontinue;
                             }
-                            /* Don't add to a[] if s2 is alias of previous sym
-                             */
-                            for (size_t j = 0; j < a->a.dim; j++)
-                            {
-                                Dsymbol *s3 = a->a[j];
-                                if (s2->toAlias() == s3->toAlias())
-                                {
-                                    if (s3->isDeprecated() ||
-                                        s2->prot() > s3->prot() && s2->prot() != PROTnone)
-                                        a->a[j] = s2;
-                                    goto Lcontinue;
-                                }
-                            }
-                            a->push(s2);
-                        Lcontinue:
-                            continue;
                         }
-                        if (flags & IgnoreAmbiguous)    // if return NULL on ambiguity
-                            return NULL;
-                        if (!(flags & IgnoreErrors))
-                            ScopeDsymbol::multiplyDefined(loc, s, s2);
-                        break;
+                        a->push(s2);
+                    Lcontinue:
+                        continue;
                     }
+                    if (flags & IgnoreAmbiguous)    // if return NULL on ambiguity
+                        return NULL;
+                    if (!(flags & IgnoreErrors))
+                        ScopeDsymbol::multiplyDefined(loc, s, s2);
+                    break;
                 }
             }
         }
+    }
 
-        /* Build special symbol if we had multiple finds
-         */
-        if (a)
-        {   assert(s);
-            a->push(s);
-            s = a;
-        }
+    /* Build special symbol if we had multiple finds
+     */
+    if (a)
+    {   assert(s);
+        a->push(s);
+        s = a;
+    }
 
-        if (s)
+    if (s)
+    {
+        if (!(flags & IgnoreErrors) && s->prot() == PROTprivate && !s->parent->isTemplateMixin())
         {
-            if (!(flags & IgnoreErrors) && s->prot() == PROTprivate && !s->parent->isTemplateMixin())
-            {
-                if (!s->isImport())
-                    error(loc, "%s %s is private", s->kind(), s->toPrettyChars());
-            }
+            if (!s->isImport())
+                error(loc, "%s %s is private", s->kind(), s->toPrettyChars());
         }
-        return s;
     }
+    return s;
 }
 
 void ScopeDsymbol::importScope(Dsymbol *s, PROT protection)
@@ -1029,6 +1102,7 @@ void ScopeDsymbol::importScope(Dsymbol *s, PROT protection)
     // No circular or redundant import's
     if (s != this)
     {
+        searchGeneration++;
         if (!imports)
             imports = new Dsymbols();
         else
@@ -1116,6 +1190,9 @@ const char *ScopeDsymbol::kind()
 
 Dsymbol *ScopeDsymbol::symtabInsert(Dsymbol *s)
 {
+    // Modules and mixins are what get imported
+    if (isModule() || isTemplateMixin())
+        searchGeneration++;
     return symtab->insert(s);
 }
 
@@ -142,6 +142,7 @@ public:
     UnitTestDeclaration *ddocUnittest; // !=NULL means there's a ddoc unittest associated with this symbol (only use this with ddoc)
 
     Dsymbol();
+    static void *operator new(size_t sz);
     Dsymbol(Identifier *);
     static Dsymbol *create(Identifier *);
     char *toChars();
@@ -284,10 +285,14 @@ public:
     Dsymbols *imports;          // imported Dsymbol's
     PROT *prots;                // array of PROT, one for each import
 
+    AA *searchCache;            // results of searching imports[], by Identifier
+    static unsigned searchGeneration;   // changes when anything that can be imported does
+
     ScopeDsymbol();
     ScopeDsymbol(Identifier *id);
     Dsymbol *syntaxCopy(Dsymbol *s);
     Dsymbol *search(Loc loc, Identifier *ident, int flags = IgnoreNone);
+    Dsymbol *searchImports(Loc loc, Identifier *ident, int flags);
     void importScope(Dsymbol *s, PROT protection);
     bool isforwardRef();
     void defineRef(Dsymbol *s);
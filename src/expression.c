@@ -37,6 +37,7 @@
 #include "parse.h"
 #include "doc.h"
 #include "aav.h"
+#include "ctfe.h"
 
 bool isArrayOpValid(Expression *e);
 Expression *createTypeInfoArray(Scope *sc, Expression *args[], size_t dim);
@@ -1897,6 +1898,17 @@ void argExpTypesToCBuffer(OutBuffer *buf, Expressions *arguments, HdrGenState *h
 
 /******************************** Expression **************************/
 
+/*********************************
+ * Expressions made while interpreting are CTFE values, which go in
+ * the region CtfeRegion frees.
+ */
+
+void *Expression::operator new(size_t size)
+{
+    MemKind kind = CtfeRegion::active ? MEMctfe : MEMexpression;
+    return mem.allocate(kind, size);
+}
+
 Expression::Expression(Loc loc, TOK op, int size)
 {
     //printf("Expression::Expression(op = %d) this = %p\n", op, this);
@@ -1945,7 +1957,7 @@ Expression *Expression::copy()
 #endif
         assert(0);
     }
-    e = (Expression *)mem.malloc(size);
+    e = (Expression *)operator new(size);
     //printf("Expression::copy(op = %d) e = %p\n", op, e);
     return (Expression *)memcpy((void*)e, (void*)this, size);
 }
@@ -7271,7 +7283,7 @@ Expression *FileExp::semantic(Scope *sc)
     }
 
     {   File f(name);
-        if (f.read())
+        if (f.mmread())
         {   error("cannot read file %s", f.toChars());
             goto Lerror;
         }
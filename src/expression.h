@@ -121,6 +121,7 @@ public:
     unsigned char parens;       // if this is a parenthesized expression
 
     Expression(Loc loc, TOK op, int size);
+    static void *operator new(size_t sz);
     static void init();
     Expression *copy();
     virtual Expression *syntaxCopy();
@@ -27,6 +27,7 @@
 #include "target.h"
 #include "parse.h"
 #include "rmem.h"
+#include "ctfe.h"
 
 void functionToCBuffer2(TypeFunction *t, OutBuffer *buf, HdrGenState *hgs, int mod, const char *kind);
 void genCmain(Scope *sc);
@@ -73,6 +74,7 @@ FuncDeclaration::FuncDeclaration(Loc loc, Loc endloc, Identifier *id, StorageCla
     inlineStatusStmt = ILSuninitialized;
     inlineNest = 0;
     ctfeCode = NULL;
+    ctfeBc = NULL;
     isArrayOp = 0;
     dArrayOp = NULL;
     semantic3Errors = false;
@@ -1880,6 +1882,7 @@ bool FuncDeclaration::functionSemantic()
         unsigned oldgag = global.gag;
         if (global.gag && !spec)
             global.gag = 0;
+        CtfeRegionSuspend crs;
         semantic(scope);
         global.gag = oldgag;
         if (spec && global.errors != olderrs)
@@ -1925,6 +1928,7 @@ bool FuncDeclaration::functionSemantic3()
         unsigned oldgag = global.gag;
         if (global.gag && !spec)
             global.gag = 0;
+        CtfeRegionSuspend crs;
         semantic3(scope);
         global.gag = oldgag;
 
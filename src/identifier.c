@@ -84,11 +84,11 @@ int Identifier::dyncast()
 
 // BUG: these are redundant with Lexer::uniqueId()
 
+THREAD_LOCAL IdSequence Identifier::sequence = { 0, 1 };
+
 Identifier *Identifier::generateId(const char *prefix)
 {
-    static size_t i;
-
-    return generateId(prefix, ++i);
+    return generateId(prefix, sequence.next());
 }
 
 Identifier *Identifier::generateId(const char *prefix, size_t i)
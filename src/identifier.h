@@ -16,6 +16,17 @@
 #endif /* __DMC__ */
 
 #include "root.h"
+#include "thread.h"
+
+/* Numbers handed out for generated identifiers.
+ */
+struct IdSequence
+{
+    size_t last;        // most recently handed out number
+    size_t stride;      // distance between consecutive numbers
+
+    size_t next() { return last += stride; }
+};
 
 class Identifier : public RootObject
 {
@@ -33,6 +44,7 @@ public:
     const char *toHChars2();
     int dyncast();
 
+    static THREAD_LOCAL IdSequence sequence;   // used by generateId(prefix)
     static Identifier *generateId(const char *prefix);
     static Identifier *generateId(const char *prefix, size_t i);
 };
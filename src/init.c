@@ -23,6 +23,7 @@
 #include "hdrgen.h"
 #include "template.h"
 #include "id.h"
+#include "ctfe.h"
 
 /********************************** Initializer *******************************/
 
@@ -975,6 +976,7 @@ Expression *ExpInitializer::toExpression(Type *t)
         {
             TypeSArray *tsa = (TypeSArray *)tb;
             size_t d = (size_t)tsa->dim->toInteger();
+            CtfeRegionSuspend crs;     // the initializer keeps it
             Expressions *elements = new Expressions();
             elements->setDim(d);
             for (size_t i = 0; i < d; i++)
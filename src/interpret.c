@@ -13,6 +13,7 @@
 #include <string.h>                     // mem{cpy|set}()
 
 #include "rmem.h"
+#include "aav.h"
 
 #include "statement.h"
 #include "expression.h"
@@ -30,15 +31,14 @@
 #include "template.h"
 #include "port.h"
 #include "ctfe.h"
+#include "timetrace.h"
+#include "outbuffer.h"
 
 #define LOG     0
 #define LOGASSIGN 0
 #define LOGCOMPILE 0
 #define SHOWPERFORMANCE 0
 
-// Maximum allowable recursive function calls in CTFE
-#define CTFE_RECURSION_LIMIT 1000
-
 /**
   The values of all CTFE variables
 */
@@ -241,10 +241,15 @@ InterState::InterState()
 /************** CtfeStatus ********************************************/
 
 int CtfeStatus::callDepth = 0;
+int CtfeStatus::evalDepth = 0;
 int CtfeStatus::stackTraceCallsToSuppress = 0;
 int CtfeStatus::maxCallDepth = 0;
 int CtfeStatus::numArrayAllocs = 0;
 int CtfeStatus::numAssignments = 0;
+int CtfeStatus::numBcCalls = 0;
+int CtfeStatus::numBcAborts = 0;
+int CtfeStatus::numMemoHits = 0;
+int CtfeStatus::numMemoMisses = 0;
 
 // CTFE diagnostic information
 void printCtfePerformanceStats()
@@ -252,10 +257,181 @@ void printCtfePerformanceStats()
 #if SHOWPERFORMANCE
     printf("        ---- CTFE Performance ----\n");
     printf("max call depth = %d\tmax stack = %d\n", CtfeStatus::maxCallDepth, ctfeStack.maxStackUsage());
-    printf("array allocs = %d\tassignments = %d\n\n", CtfeStatus::numArrayAllocs, CtfeStatus::numAssignments);
+    printf("array allocs = %d\tassignments = %d\n", CtfeStatus::numArrayAllocs, CtfeStatus::numAssignments);
+    printf("bytecode calls = %d\tgiven up = %d\n", CtfeStatus::numBcCalls, CtfeStatus::numBcAborts);
+    printf("memo hits = %d\tmisses = %d\n\n", CtfeStatus::numMemoHits, CtfeStatus::numMemoMisses);
 #endif
 }
 
+/************** CtfeProfile *******************************************/
+
+/* Where the time and memory of CTFE go, per function, for -ctfeprofile.
+ * Calls the bytecode VM makes to other VM functions are part of their
+ * caller.
+ */
+struct CtfeProfileEntry
+{
+    FuncDeclaration *fd;
+    unsigned calls;
+    ulonglong inclusive;        // microseconds, with the functions it calls
+    ulonglong exclusive;        // microseconds in the function itself
+    size_t bytes;               // CTFE memory allocated by the function itself
+    size_t objects;
+    Loc site;                   // compile time evaluation that first called it
+    unsigned active;            // calls in progress, so recursion is timed once
+};
+
+struct CtfeProfileFrame
+{
+    CtfeProfileEntry *pe;
+    ulonglong start;
+    ulonglong callees;          // inclusive time of the calls it made
+    size_t bytes;               // CTFE memory allocated before the call
+    size_t objects;
+    size_t calleeBytes;         // and by the calls it made
+    size_t calleeObjects;
+};
+
+Loc CtfeProfile::site;
+static AA *profileEntries;      // FuncDeclaration => CtfeProfileEntry
+static Array<CtfeProfileEntry *> profileList;
+static CtfeProfileFrame *profileStack;
+static size_t profileDepth;
+static size_t profileDim;
+
+static void ctfeMemUsed(size_t *bytes, size_t *objects)
+{
+    MemStats stats;
+    mem.takeStats(&stats);
+    mem.addStats(&stats);
+    *bytes = stats.bytes[MEMctfe];
+    *objects = stats.objects[MEMctfe];
+}
+
+void CtfeProfile::enter(FuncDeclaration *fd)
+{
+    CtfeProfileEntry **ppe = (CtfeProfileEntry **)_aaGet(&profileEntries, fd);
+    CtfeProfileEntry *pe = *ppe;
+    if (!pe)
+    {
+        pe = new CtfeProfileEntry();
+        pe->fd = fd;
+        pe->site = site.filename ? site : fd->loc;
+        *ppe = pe;
+        profileList.push(pe);
+    }
+    pe->calls++;
+    pe->active++;
+
+    if (profileDepth == profileDim)
+    {
+        profileDim = profileDim ? profileDim * 2 : 64;
+        profileStack = (CtfeProfileFrame *)mem.realloc(profileStack, profileDim * sizeof(CtfeProfileFrame));
+    }
+    CtfeProfileFrame *f = &profileStack[profileDepth++];
+    memset(f, 0, sizeof(CtfeProfileFrame));
+    f->pe = pe;
+    ctfeMemUsed(&f->bytes, &f->objects);
+    f->start = TimeTrace::now();
+}
+
+void CtfeProfile::leave()
+{
+    assert(profileDepth);
+    CtfeProfileFrame *f = &profileStack[--profileDepth];
+    CtfeProfileEntry *pe = f->pe;
+    ulonglong dur = TimeTrace::now() - f->start;
+    size_t bytes, objects;
+    ctfeMemUsed(&bytes, &objects);
+    bytes -= f->bytes;
+    objects -= f->objects;
+
+    pe->active--;
+    if (!pe->active)
+        pe->inclusive += dur;
+    pe->exclusive += dur - f->callees;
+    pe->bytes += bytes - f->calleeBytes;
+    pe->objects += objects - f->calleeObjects;
+    if (profileDepth)
+    {
+        CtfeProfileFrame *caller = &profileStack[profileDepth - 1];
+        caller->callees += dur;
+        caller->calleeBytes += bytes;
+        caller->calleeObjects += objects;
+    }
+}
+
+static int cmpProfileEntries(const void *p1, const void *p2)
+{
+    CtfeProfileEntry *pe1 = *(CtfeProfileEntry **)p1;
+    CtfeProfileEntry *pe2 = *(CtfeProfileEntry **)p2;
+    if (pe1->inclusive != pe2->inclusive)
+        return pe1->inclusive < pe2->inclusive ? 1 : -1;
+    if (pe1->exclusive != pe2->exclusive)
+        return pe1->exclusive < pe2->exclusive ? 1 : -1;
+    return pe1->calls < pe2->calls ? 1 : pe1->calls > pe2->calls ? -1 : 0;
+}
+
+static void writeJsonString(OutBuffer *buf, const char *s)
+{
+    buf->writeByte('"');
+    for (; *s; s++)
+    {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\')
+        {
+            buf->writeByte('\\');
+            buf->writeByte(c);
+        }
+        else if (c < ' ')
+            buf->printf("\\u%04x", c);
+        else
+            buf->writeByte(c);
+    }
+    buf->writeByte('"');
+}
+
+/*******************************
+ * Write what was recorded, with the most expensive functions first,
+ * either as a table or as a JSON array.
+ */
+
+void CtfeProfile::write(OutBuffer *buf, bool json)
+{
+    qsort(profileList.data, profileList.dim, sizeof(CtfeProfileEntry *), &cmpProfileEntries);
+
+    if (json)
+        buf->writestring("[\n");
+    else
+        buf->writestring("    calls  incl ms  excl ms  alloc kB  function, first called from\n");
+    for (size_t i = 0; i < profileList.dim; i++)
+    {
+        CtfeProfileEntry *pe = profileList[i];
+        const char *name = pe->fd->toPrettyChars();
+        const char *site = pe->site.toChars();
+        if (json)
+        {
+            buf->writestring("{\"name\":");
+            writeJsonString(buf, name);
+            buf->writestring(",\"site\":");
+            writeJsonString(buf, site);
+            buf->printf(",\"calls\":%u,\"inclusive_us\":%llu,\"exclusive_us\":%llu,"
+                "\"alloc_bytes\":%llu,\"alloc_objects\":%llu}%s\n",
+                pe->calls, pe->inclusive, pe->exclusive,
+                (ulonglong)pe->bytes, (ulonglong)pe->objects,
+                i + 1 == profileList.dim ? "" : ",");
+        }
+        else
+        {
+            buf->printf("%9u %8llu %8llu %9llu  %s, %s\n",
+                pe->calls, pe->inclusive / 1000, pe->exclusive / 1000,
+                (ulonglong)(pe->bytes / 1024), name, site);
+        }
+    }
+    if (json)
+        buf->writestring("]\n");
+}
+
 
 Expression * resolveReferences(Expression *e);
 Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal);
@@ -269,18 +445,25 @@ Expression *scrubReturnValue(Loc loc, Expression *e);
 /*************************************
  * CTFE-object code for a single function
  *
- * Currently only counts the number of local variables in the function
+ * Currently only counts the number of local variables in the function,
+ * and finds the local arrays that ~= can grow in place.
  */
 struct CompiledCtfeFunction
 {
     FuncDeclaration *func; // Function being compiled, NULL if global scope
     int numVars;           // Number of variables declared in this function
     Loc callingloc;
+    AA *arrayRefs;         // Local arrays => 1 + number of references that could alias them
+    AA *memo;              // Hash of the arguments => MemoEntry list, for -ctfememo
+    int memoizable;        // 0: not known yet, 1: results can be memoized, -1: they can't
 
     CompiledCtfeFunction(FuncDeclaration *f)
     {
         func = f;
         numVars = 0;
+        arrayRefs = NULL;
+        memo = NULL;
+        memoizable = 0;
     }
 
     void onDeclaration(VarDeclaration *v)
@@ -293,8 +476,146 @@ struct CompiledCtfeFunction
     {
         e->apply(&walkAllVars, this);
     }
+    void onArrayRef(Expression *e, int n);
+    bool canAppendInPlace(Declaration *d);
+    bool canMemoize();
+    Expression *memoLookup(Expressions *args, hash_t hash);
+    void memoStore(Expressions *args, hash_t hash, Expression *e);
 };
 
+/* Count a reference to a local array of scalars, with n = -1 for one
+ * that cannot leave an alias of its value behind: reading or writing
+ * an element, taking its length, comparing it, appending to it in an
+ * expression statement, assigning a new array to it, and returning it.
+ * Indexing it for &a[i] or for a ref argument does keep a reference to
+ * the element, so walkAllVars() adds those back. Once all references
+ * are of the first kind, nothing but the variable can refer to its value.
+ */
+void CompiledCtfeFunction::onArrayRef(Expression *e, int n)
+{
+    if (!func || e->op != TOKvar)
+        return;
+    VarDeclaration *v = ((VarExp *)e)->var->isVarDeclaration();
+    if (!v || v->toParent2() != func || v == func->vresult || v->nestedrefs.dim ||
+        (v->storage_class & (STCparameter | STCref | STCout | STClazy | STCmanifest)) ||
+        v->isStatic() || v->isDataseg())
+        return;
+    Type *tb = v->type->toBasetype();
+    if (tb->ty != Tarray)
+        return;
+    Type *tn = tb->nextOf()->toBasetype();
+    if (!tn->isintegral() && !tn->isfloating())
+        return;
+    size_t *pn = (size_t *)_aaGet(&arrayRefs, v);
+    if (!*pn)
+        *pn = 1;
+    *pn += n;
+}
+
+bool CompiledCtfeFunction::canAppendInPlace(Declaration *d)
+{
+    return (size_t)_aaGetRvalue(arrayRefs, d) == 1;
+}
+
+/* A previous call of a memoized function, see -ctfememo
+ */
+struct MemoEntry
+{
+    Expressions *args;
+    Expression *result;
+    MemoEntry *next;            // next entry whose arguments have the same hash
+};
+
+/* Types whose CTFE values are plain data: scalars, and arrays of
+ * immutable integers such as strings.
+ */
+static bool isMemoValueType(Type *t)
+{
+    Type *tb = t->toBasetype();
+    if (tb->ty == Tarray)
+    {
+        Type *tn = tb->nextOf();
+        return tn->isImmutable() && tn->toBasetype()->isintegral();
+    }
+    return tb->isintegral() || tb->isfloating();
+}
+
+/* A strongly pure function of values always returns the same value for
+ * the same arguments, so a repeated call can reuse the earlier result.
+ */
+bool CompiledCtfeFunction::canMemoize()
+{
+    if (!memoizable)
+    {
+        memoizable = -1;
+        TypeFunction *tf = (TypeFunction *)func->type->toBasetype();
+        if (func->isPure() != PUREstrong || func->needThis() || func->isNested() ||
+            tf->isref || tf->varargs || !isMemoValueType(tf->next))
+            return false;
+        size_t nparams = Parameter::dim(tf->parameters);
+        for (size_t i = 0; i < nparams; i++)
+        {
+            Parameter *arg = Parameter::getNth(tf->parameters, i);
+            if ((arg->storageClass & (STCout | STCref | STClazy)) ||
+                !isMemoValueType(arg->type))
+                return false;
+        }
+        memoizable = 1;
+    }
+    return memoizable > 0;
+}
+
+/* Copy of an argument or result to keep in the memo cache, so that
+ * later changes to the array it was a slice of don't show through,
+ * and that outlives the CTFE region. NULL if it can't be kept.
+ */
+static Expression *memoValue(Expression *e)
+{
+    if (e->op == TOKslice)
+        e = resolveSlice(e);
+    return copyOutOfRegion(e);
+}
+
+Expression *CompiledCtfeFunction::memoLookup(Expressions *args, hash_t hash)
+{
+    for (MemoEntry *me = (MemoEntry *)_aaGetRvalue(memo, (void *)hash); me; me = me->next)
+    {
+        size_t i;
+        for (i = 0; i < args->dim; i++)
+        {
+            Expression *a = (*args)[i];
+            Expression *b = (*me->args)[i];
+            // Scalars must be identical, or f(-0.0) would reuse f(0.0),
+            // and f(null) must not reuse f("")
+            if (a->type->toBasetype()->ty == Tarray ? (a->op == TOKnull) != (b->op == TOKnull) ||
+                             !ctfeEqual(a->loc, TOKequal, a, b)
+                           : !ctfeIdentity(a->loc, TOKidentity, a, b))
+                break;
+        }
+        if (i == args->dim)
+            return me->result;
+    }
+    return NULL;
+}
+
+void CompiledCtfeFunction::memoStore(Expressions *args, hash_t hash, Expression *e)
+{
+    CtfeStatus::numMemoMisses++;
+    MemoEntry *me = new MemoEntry();
+    me->args = new Expressions();
+    me->args->setDim(args->dim);
+    for (size_t i = 0; i < args->dim; i++)
+    {
+        if (!((*me->args)[i] = memoValue((*args)[i])))
+            return;
+    }
+    if (!(me->result = memoValue(e)))
+        return;
+    MemoEntry **pme = (MemoEntry **)_aaGet(&memo, (void *)hash);
+    me->next = *pme;
+    *pme = me;
+}
+
 int CompiledCtfeFunction::walkAllVars(Expression *e, void *_this)
 {
     CompiledCtfeFunction *ccf = (CompiledCtfeFunction *)_this;
@@ -346,6 +667,67 @@ int CompiledCtfeFunction::walkAllVars(Expression *e, void *_this)
         ccf->onDeclaration( ((IndexExp *)e)->lengthVar);
     else if (e->op == TOKslice && ((SliceExp *)e)->lengthVar)
         ccf->onDeclaration( ((SliceExp *)e)->lengthVar);
+
+    switch (e->op)
+    {
+        case TOKvar:
+            ccf->onArrayRef(e, 1);
+            break;
+        case TOKindex:
+            ccf->onArrayRef(((IndexExp *)e)->e1, -1);
+            break;
+        case TOKaddress:
+            if (((AddrExp *)e)->e1->op == TOKindex)
+                ccf->onArrayRef(((IndexExp *)((AddrExp *)e)->e1)->e1, 1);
+            break;
+        case TOKcall:
+        {
+            CallExp *ce = (CallExp *)e;
+            Type *t = ce->e1->type->toBasetype();
+            if (t->ty == Tdelegate || t->ty == Tpointer)
+                t = t->nextOf()->toBasetype();
+            if (t->ty != Tfunction || !ce->arguments)
+                break;
+            TypeFunction *tf = (TypeFunction *)t;
+            for (size_t i = 0; i < ce->arguments->dim; i++)
+            {
+                Expression *earg = (*ce->arguments)[i];
+                Parameter *arg = Parameter::getNth(tf->parameters, i);
+                if (arg && (arg->storageClass & (STCout | STCref)) && earg->op == TOKindex)
+                    ccf->onArrayRef(((IndexExp *)earg)->e1, 1);
+            }
+            break;
+        }
+        case TOKarraylength:
+            ccf->onArrayRef(((ArrayLengthExp *)e)->e1, -1);
+            break;
+        case TOKequal:
+        case TOKnotequal:
+        case TOKlt:
+        case TOKle:
+        case TOKgt:
+        case TOKge:
+            ccf->onArrayRef(((BinExp *)e)->e1, -1);
+            ccf->onArrayRef(((BinExp *)e)->e2, -1);
+            break;
+        case TOKassign:
+        case TOKconstruct:
+        case TOKblit:
+            switch (((AssignExp *)e)->e2->op)
+            {
+                case TOKnull:
+                case TOKstring:
+                case TOKarrayliteral:
+                case TOKnew:
+                    ccf->onArrayRef(((AssignExp *)e)->e1, -1);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
     return 0;
 }
 
@@ -363,7 +745,11 @@ void ExpStatement::ctfeCompile(CompiledCtfeFunction *ccf)
     printf("%s ExpStatement::ctfeCompile\n", loc.toChars());
 #endif
     if (exp)
+    {
         ccf->onExpression(exp);
+        if (exp->op == TOKcatass)
+            ccf->onArrayRef(((CatAssignExp *)exp)->e1, -1);
+    }
 }
 
 void CompoundStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -527,7 +913,10 @@ void ReturnStatement::ctfeCompile(CompiledCtfeFunction *ccf)
     printf("%s ReturnStatement::ctfeCompile\n", loc.toChars());
 #endif
     if (exp)
+    {
         ccf->onExpression(exp);
+        ccf->onArrayRef(exp, -1);
+    }
 }
 
 void BreakStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -689,9 +1078,18 @@ Expression *Expression::ctfeInterpret()
     ctfeCodeGlobal.callingloc = loc;
     ctfeCodeGlobal.onExpression(this);
 
+    TimeTraceScope tts("CTFE", this);
+    Loc oldsite = CtfeProfile::site;
+    CtfeProfile::site = loc;
+    CtfeRegion region;
+    region.begin();
+    CtfeStatus::evalDepth++;
     Expression *e = interpret(NULL);
     if (e != EXP_CANT_INTERPRET)
         e = scrubReturnValue(loc, e);
+    CtfeStatus::evalDepth--;
+    e = region.end(e);
+    CtfeProfile::site = oldsite;
     if (e == EXP_CANT_INTERPRET)
         e = new ErrorExp();
     return e;
@@ -761,6 +1159,7 @@ Expression *ctfeInterpretForPragmaMsg(Expression *e)
 
 Expression *FuncDeclaration::interpret(InterState *istate, Expressions *arguments, Expression *thisarg)
 {
+    TimeTraceScope tts("CTFE call", this);
 #if LOG
     printf("\n********\n%s FuncDeclaration::interpret(istate = %p) %s\n", loc.toChars(), istate, toChars());
 #endif
@@ -880,6 +1279,39 @@ Expression *FuncDeclaration::interpret(InterState *istate, Expressions *argument
         }
     }
 
+    CtfeProfileScope cps(this);
+
+    // A strongly pure function called again with the same arguments
+    hash_t memoHash = 0;
+    bool memoize = global.params.ctfeMemo && ctfeCode->canMemoize();
+    if (memoize)
+    {
+        for (size_t i = 0; i < dim; i++)
+            memoHash = memoHash * 31 + ctfeHash(eargs[i]);
+        Expression *e = ctfeCode->memoLookup(&eargs, memoHash);
+        if (e)
+        {
+            CtfeStatus::numMemoHits++;
+            return e->op == TOKstring || e->op == TOKarrayliteral ? copyLiteral(e) : e;
+        }
+    }
+
+    // Functions that only compute on integers run much faster in the VM
+    if (!thisarg)
+    {
+        BcFunction *bf = bcCompile(this);
+        if (bf)
+        {
+            Expression *e = bcRun(bf, &eargs);
+            if (e)
+            {
+                if (memoize)
+                    ctfeCode->memoStore(&eargs, memoHash, e);
+                return e;
+            }
+        }
+    }
+
     // Now that we've evaluated all the arguments, we can start the frame
     // (this is the moment when the 'call' actually takes place).
 
@@ -999,6 +1431,8 @@ Expression *FuncDeclaration::interpret(InterState *istate, Expressions *argument
         return EXP_CANT_INTERPRET;
     }
 
+    if (memoize)
+        ctfeCode->memoStore(&eargs, memoHash, e);
     return e;
 }
 
@@ -1276,10 +1710,12 @@ Expression *scrubReturnValue(Loc loc, Expression *e)
     if (e->op == TOKstring)
     {
         ((StringExp *)e)->ownedByCtfe = false;
+        ctfeEndAppend(e);
     }
     if (e->op == TOKarrayliteral)
     {
         ((ArrayLiteralExp *)e)->ownedByCtfe = false;
+        ctfeEndAppend(e);
         if (!scrubArray(loc, ((ArrayLiteralExp *)e)->elements))
             return EXP_CANT_INTERPRET;
     }
@@ -2315,6 +2751,7 @@ Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal
 
         if (!v->originalType && v->scope)   // semantic() not yet run
         {
+            CtfeRegionSuspend crs;
             v->semantic (v->scope);
             if (v->type->ty == Terror)
                 return EXP_CANT_INTERPRET;
@@ -2328,7 +2765,10 @@ Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal
         if (doinit && v->init && !v->isCTFE())
         {
             if(v->scope)
+            {
+                CtfeRegionSuspend crs;
                 v->init = v->init->semantic(v->scope, v->type, INITinterpret); // might not be run on aggregate members
+            }
             e = v->init->toExpression(v->type);
             if (v->inuse)
             {
@@ -2365,7 +2805,15 @@ Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal
             {
                 e = copyLiteral(e);
                 if (v->isDataseg() || (v->storage_class & STCmanifest ))
+                {
+                    // Kept for later evaluations, so it mustn't be in the region
+                    Expression *ecopy = copyOutOfRegion(e);
+                    if (ecopy)
+                        e = ecopy;
+                    else
+                        CtfeRegion::pinned = true;
                     ctfeStack.saveGlobalConstant(v, e);
+                }
             }
         }
         else if (v->isCTFE() && !v->hasValue())
@@ -3454,7 +3902,11 @@ Expression *BinExp::interpretAssignCommon(InterState *istate, CtfeGoal goal, fp_
             }
             else
             {
-                newval = (*fp)(type, oldval, newval);
+                Expression *e = NULL;
+                if (op == TOKcatass && this->e1->op == TOKvar && istate && istate->fd &&
+                    istate->fd->ctfeCode && istate->fd->ctfeCode->canAppendInPlace(((VarExp *)this->e1)->var))
+                    e = ctfeAppend(type, oldval, newval);
+                newval = e ? e : (*fp)(type, oldval, newval);
             }
             if (newval == EXP_CANT_INTERPRET)
             {
@@ -6037,6 +6489,8 @@ Expression *RemoveExp::interpret(InterState *istate, CtfeGoal goal)
     }
     valuesx->dim = valuesx->dim - removed;
     keysx->dim = keysx->dim - removed;
+    if (removed)
+        resetAAIndex(aae);
     return new IntegerExp(loc, removed?1:0, Type::tbool);
 }
 
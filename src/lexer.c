@@ -64,6 +64,151 @@ static void cmtable_init()
     }
 }
 
+/********************************************
+ * Scanners for the runs of plain ASCII characters that make up most
+ * of the source. With SSE2 they look at 16 bytes at a time; the loads
+ * are aligned, so they never cross into a page past the 0 that ends
+ * every buffer the lexer is given.
+ */
+
+#if __SSE2__ && __GNUC__
+#define SCAN_SIMD 1
+#include <emmintrin.h>
+
+#if __SANITIZE_ADDRESS__
+// Reading the rest of the block that holds the final 0 is intended
+#define SCAN_NOASAN __attribute__((no_sanitize_address))
+#else
+#define SCAN_NOASAN
+#endif
+
+// Bit mask of the bytes of x that are in lo..hi
+static inline unsigned inRange(__m128i x, utf8_t lo, utf8_t hi)
+{
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8((char)lo));
+    __m128i top = _mm_set1_epi8((char)(hi - lo));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, top), d));
+}
+
+// Bit mask of the bytes of x that are c
+static inline unsigned isByte(__m128i x, utf8_t c)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8((char)c)));
+}
+#else
+#define SCAN_NOASAN
+#endif
+
+/* Skip ' ', '\t', '\v' and '\f'.
+ */
+SCAN_NOASAN
+static const utf8_t *skipSpaces(const utf8_t *p)
+{
+#if SCAN_SIMD
+    size_t off = (size_t)p & 15;
+    const __m128i *q = (const __m128i *)(p - off);
+    unsigned live = (0xFFFF << off) & 0xFFFF;  // bytes at or after p
+    while (1)
+    {
+        __m128i x = _mm_load_si128(q);
+        unsigned m = ~(isByte(x, ' ') | isByte(x, '\t') | isByte(x, '\v') | isByte(x, '\f')) & live;
+        if (m)
+            return (const utf8_t *)q + __builtin_ctz(m);
+        live = 0xFFFF;
+        q++;
+    }
+#else
+    while (*p == ' ' || *p == '\t' || *p == '\v' || *p == '\f')
+        p++;
+    return p;
+#endif
+}
+
+/* Skip ASCII identifier characters.
+ */
+SCAN_NOASAN
+static const utf8_t *skipIdchars(const utf8_t *p)
+{
+#if SCAN_SIMD
+    size_t off = (size_t)p & 15;
+    const __m128i *q = (const __m128i *)(p - off);
+    unsigned live = (0xFFFF << off) & 0xFFFF;
+    while (1)
+    {
+        __m128i x = _mm_load_si128(q);
+        __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        unsigned m = ~(inRange(lower, 'a', 'z') | inRange(x, '0', '9') | isByte(x, '_')) & live;
+        if (m)
+            return (const utf8_t *)q + __builtin_ctz(m);
+        live = 0xFFFF;
+        q++;
+    }
+#else
+    while (isidchar(*p))
+        p++;
+    return p;
+#endif
+}
+
+/* Skip to the first c1, c2, '\r', 0, 0x1A or non-ASCII byte,
+ * adding the number of '\n's passed over to *nlines.
+ */
+SCAN_NOASAN
+static const utf8_t *skipTo(const utf8_t *p, utf8_t c1, utf8_t c2, unsigned *nlines)
+{
+#if SCAN_SIMD
+    size_t off = (size_t)p & 15;
+    const __m128i *q = (const __m128i *)(p - off);
+    unsigned live = (0xFFFF << off) & 0xFFFF;
+    while (1)
+    {
+        __m128i x = _mm_load_si128(q);
+        unsigned m = (isByte(x, c1) | isByte(x, c2) | isByte(x, '\r') |
+                      isByte(x, 0) | isByte(x, 0x1A) | _mm_movemask_epi8(x)) & live;
+        unsigned nl = isByte(x, '\n') & live;
+        if (m)
+        {
+            unsigned i = __builtin_ctz(m);
+            *nlines += __builtin_popcount(nl & ((1u << i) - 1));
+            return (const utf8_t *)q + i;
+        }
+        *nlines += __builtin_popcount(nl);
+        live = 0xFFFF;
+        q++;
+    }
+#else
+    while (1)
+    {
+        utf8_t c = *p;
+        if (c == c1 || c == c2 || c == '\r' || c == 0 || c == 0x1A || c & 0x80)
+            return p;
+        if (c == '\n')
+            (*nlines)++;
+        p++;
+    }
+#endif
+}
+
+/********************************************
+ * Values for __DATE__, __TIME__ and __TIMESTAMP__.
+ * Computed once up front so lexers running in parallel only read them.
+ */
+
+static char datestr[11+1];
+static char timestr[8+1];
+static char timestampstr[24+1];
+
+static void datetime_init()
+{
+    time_t ct;
+    ::time(&ct);
+    char *p = ctime(&ct);
+    assert(p);
+    sprintf(&datestr[0], "%.6s %.4s", p + 4, p + 20);
+    sprintf(&timestr[0], "%.8s", p + 11);
+    sprintf(&timestampstr[0], "%.24s", p);
+}
+
 
 /************************* Token **********************************************/
 
@@ -79,7 +224,7 @@ void *Token::operator new(size_t size)
         return t;
     }
 
-    return ::operator new(size);
+    return mem.allocate(MEMtoken, size);
 }
 
 #ifdef DEBUG
@@ -91,7 +236,7 @@ void Token::print()
 
 const char *Token::toChars()
 {   const char *p;
-    static char buffer[3 + 3 * sizeof(float80value) + 1];
+    static THREAD_LOCAL char buffer[3 + 3 * sizeof(float80value) + 1];
 
     p = &buffer[0];
     switch (value)
@@ -226,7 +371,7 @@ const char *Token::toChars()
 
 const char *Token::toChars(TOK value)
 {   const char *p;
-    static char buffer[3 + 3 * sizeof(value) + 1];
+    static THREAD_LOCAL char buffer[3 + 3 * sizeof(value) + 1];
 
     p = tochars[value];
     if (!p)
@@ -238,9 +383,10 @@ const char *Token::toChars(TOK value)
 
 /*************************** Lexer ********************************************/
 
-Token *Lexer::freelist = NULL;
+THREAD_LOCAL Token *Lexer::freelist = NULL;
 StringTable Lexer::stringtable;
-OutBuffer Lexer::stringbuffer;
+Mutex *Lexer::stringtableLock = NULL;
+THREAD_LOCAL IdSequence Lexer::uniqueIdSequence = { 0, 1 };
 
 Lexer::Lexer(Module *mod,
         const utf8_t *base, size_t begoffset, size_t endoffset,
@@ -487,7 +633,7 @@ void Lexer::scan(Token *t)
             case '\t':
             case '\v':
             case '\f':
-                p++;
+                p = skipSpaces(p + 1);
                 continue;                       // skip white space
 
             case '\r':
@@ -596,10 +742,9 @@ void Lexer::scan(Token *t)
 
                 while (1)
                 {
-                    c = *++p;
-                    if (isidchar(c))
-                        continue;
-                    else if (c & 0x80)
+                    p = skipIdchars(p + 1);
+                    c = *p;
+                    if (c & 0x80)
                     {   const utf8_t *s = p;
                         unsigned u = decodeUTF();
                         if (isUniAlpha(u))
@@ -610,42 +755,20 @@ void Lexer::scan(Token *t)
                     break;
                 }
 
-                StringValue *sv = stringtable.update((char *)t->ptr, p - t->ptr);
-                Identifier *id = (Identifier *) sv->ptrvalue;
-                if (!id)
-                {   id = new Identifier(sv->toDchars(),TOKidentifier);
-                    sv->ptrvalue = (char *)id;
-                }
+                Identifier *id = idPool((const char *)t->ptr, p - t->ptr);
                 t->ident = id;
                 t->value = (TOK) id->value;
                 anyToken = 1;
                 if (*t->ptr == '_')     // if special identifier token
                 {
-                    static bool initdone = false;
-                    static char date[11+1];
-                    static char time[8+1];
-                    static char timestamp[24+1];
-
-                    if (!initdone)       // lazy evaluation
-                    {
-                        initdone = true;
-                        time_t ct;
-                        ::time(&ct);
-                        char *p = ctime(&ct);
-                        assert(p);
-                        sprintf(&date[0], "%.6s %.4s", p + 4, p + 20);
-                        sprintf(&time[0], "%.8s", p + 11);
-                        sprintf(&timestamp[0], "%.24s", p);
-                    }
-
                     if (id == Id::DATE)
                     {
-                        t->ustring = (utf8_t *)date;
+                        t->ustring = (utf8_t *)datestr;
                         goto Lstr;
                     }
                     else if (id == Id::TIME)
                     {
-                        t->ustring = (utf8_t *)time;
+                        t->ustring = (utf8_t *)timestr;
                         goto Lstr;
                     }
                     else if (id == Id::VENDOR)
@@ -655,7 +778,7 @@ void Lexer::scan(Token *t)
                     }
                     else if (id == Id::TIMESTAMP)
                     {
-                        t->ustring = (utf8_t *)timestamp;
+                        t->ustring = (utf8_t *)timestampstr;
                      Lstr:
                         t->value = TOKstring;
                         t->postfix = 0;
@@ -712,7 +835,8 @@ void Lexer::scan(Token *t)
                         while (1)
                         {
                             while (1)
-                            {   utf8_t c = *p;
+                            {   p = skipTo(p, '/', '/', &scanloc.linnum);
+                                utf8_t c = *p;
                                 switch (c)
                                 {
                                     case '/':
@@ -768,7 +892,8 @@ void Lexer::scan(Token *t)
                     case '/':           // do // style comments
                         linnum = scanloc.linnum;
                         while (1)
-                        {   utf8_t c = *++p;
+                        {   p = skipTo(p + 1, '\n', '\n', &scanloc.linnum);
+                            utf8_t c = *p;
                             switch (c)
                             {
                                 case '\n':
@@ -830,7 +955,8 @@ void Lexer::scan(Token *t)
                         p++;
                         nest = 1;
                         while (1)
-                        {   utf8_t c = *p;
+                        {   p = skipTo(p, '/', '+', &scanloc.linnum);
+                            utf8_t c = *p;
                             switch (c)
                             {
                                 case '/':
@@ -1329,6 +1455,9 @@ TOK Lexer::wysiwygStringConstant(Token *t, int tc)
     stringbuffer.reset();
     while (1)
     {
+        const utf8_t *s = p;
+        p = skipTo(p, tc, tc, &scanloc.linnum);
+        stringbuffer.write(s, p - s);
         c = *p++;
         switch (c)
         {
@@ -1693,6 +1822,9 @@ TOK Lexer::escapeStringConstant(Token *t, int wide)
     stringbuffer.reset();
     while (1)
     {
+        const utf8_t *s = p;
+        p = skipTo(p, '"', '\\', &scanloc.linnum);
+        stringbuffer.write(s, p - s);
         c = *p++;
         switch (c)
         {
@@ -2624,7 +2756,13 @@ const utf8_t *Lexer::combineComments(const utf8_t *c1, const utf8_t *c2)
 
 Identifier *Lexer::idPool(const char *s)
 {
-    size_t len = strlen(s);
+    return idPool(s, strlen(s));
+}
+
+Identifier *Lexer::idPool(const char *s, size_t len)
+{
+    if (stringtableLock)
+        stringtableLock->lock();
     StringValue *sv = stringtable.update(s, len);
     Identifier *id = (Identifier *) sv->ptrvalue;
     if (!id)
@@ -2632,6 +2770,8 @@ Identifier *Lexer::idPool(const char *s)
         id = new Identifier(sv->toDchars(), TOKidentifier);
         sv->ptrvalue = (char *)id;
     }
+    if (stringtableLock)
+        stringtableLock->unlock();
     return id;
 }
 
@@ -2652,8 +2792,7 @@ Identifier *Lexer::uniqueId(const char *s, int num)
 
 Identifier *Lexer::uniqueId(const char *s)
 {
-    static int num;
-    return uniqueId(s, ++num);
+    return uniqueId(s, (int)uniqueIdSequence.next());
 }
 
 /****************************************
@@ -2812,6 +2951,7 @@ void Lexer::initKeywords()
     stringtable._init(6151);
 
     cmtable_init();
+    datetime_init();
 
     for (nkeywords = 0; keywords[nkeywords].name; nkeywords++)
     {
@@ -17,8 +17,10 @@
 
 #include "root.h"
 #include "mars.h"
+#include "identifier.h"
 
 struct StringTable;
+struct Mutex;
 class Identifier;
 class Module;
 
@@ -226,8 +228,11 @@ class Lexer
 {
 public:
     static StringTable stringtable;
-    static OutBuffer stringbuffer;
-    static Token *freelist;
+    static Mutex *stringtableLock;      // guards stringtable when lexing in parallel
+    static THREAD_LOCAL Token *freelist;
+    static THREAD_LOCAL IdSequence uniqueIdSequence;   // used by uniqueId(s)
+
+    OutBuffer stringbuffer;
 
     Loc scanloc;                // for error messages
 
@@ -246,6 +251,7 @@ public:
 
     static void initKeywords();
     static Identifier *idPool(const char *s);
+    static Identifier *idPool(const char *s, size_t len);
     static Identifier *uniqueId(const char *s);
     static Identifier *uniqueId(const char *s, int num);
 
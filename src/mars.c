@@ -17,11 +17,15 @@
 
 #if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
 #include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #endif
 
 #include "rmem.h"
 #include "root.h"
 #include "async.h"
+#include "thread.h"
+#include "timetrace.h"
 #include "target.h"
 
 #include "mars.h"
@@ -35,6 +39,7 @@
 #include "lib.h"
 #include "json.h"
 #include "declaration.h"
+#include "ctfe.h"
 
 int response_expand(size_t *pargc, const char ***pargv);
 void browse(const char *url);
@@ -47,6 +52,19 @@ void printCtfePerformanceStats();
 
 static bool parse_arch(size_t argc, const char** argv, bool is64bit);
 
+/* Names for -mcpu=, indexed by the MODELxxx values in backend/cdef.h
+ */
+static const char *mcpuNames[] =
+{
+    "none",
+    "generic",
+    "core2",
+    "sandybridge",
+    "haswell",
+    "skylake",
+    "zen",
+};
+
 /** Normalize path by turning forward slashes into backslashes */
 void toWinPath(char *src)
 {
@@ -265,11 +283,23 @@ void verrorPrint(Loc loc, const char *header, const char *format, va_list ap,
     fflush(stderr);
 }
 
+/* Serializes diagnostics and the error counts while
+ * source files are being parsed in parallel.
+ */
+static Mutex *diagnosticLock = NULL;
+
+struct DiagnosticGuard
+{
+    DiagnosticGuard() { if (diagnosticLock) diagnosticLock->lock(); }
+    ~DiagnosticGuard() { if (diagnosticLock) diagnosticLock->unlock(); }
+};
+
 // header is "Error: " by default (see mars.h)
 extern "C" {
 void verror(Loc loc, const char *format, va_list ap,
                 const char *p1, const char *p2, const char *header)
 {
+    DiagnosticGuard guard;
     if (!global.gag)
     {
         verrorPrint(loc, header, format, ap, p1, p2);
@@ -290,12 +320,14 @@ void verror(Loc loc, const char *format, va_list ap,
 // Doesn't increase error count, doesn't print "Error:".
 void verrorSupplemental(Loc loc, const char *format, va_list ap)
 {
+    DiagnosticGuard guard;
     if (!global.gag)
         verrorPrint(loc, "       ", format, ap);
 }
 
 void vwarning(Loc loc, const char *format, va_list ap)
 {
+    DiagnosticGuard guard;
     if (global.params.warnings && !global.gag)
     {
         verrorPrint(loc, "Warning: ", format, ap);
@@ -309,6 +341,7 @@ void vdeprecation(Loc loc, const char *format, va_list ap,
                 const char *p1, const char *p2)
 {
     static const char *header = "Deprecation: ";
+    DiagnosticGuard guard;
     if (global.params.useDeprecated == 0)
         verror(loc, format, ap, p1, p2, header);
     else if (global.params.useDeprecated == 2 && !global.gag)
@@ -375,6 +408,7 @@ void halt()
 
 extern void backend_init();
 extern void backend_term();
+void el_stats(unsigned *count, unsigned *peak, size_t *size);
 
 void usage()
 {
@@ -399,6 +433,10 @@ Usage:\n\
   -c             do not link\n\
   -cov           do code coverage analysis\n\
   -cov=nnn       require at least nnn%% code coverage\n\
+  -ctfememo      reuse results of pure functions run at compile time\n\
+  -ctfeprofile   print the cost of each function run at compile time\n\
+  -ctfeprofile=filename\n\
+                 write it to filename as JSON\n\
   -D             generate documentation\n\
   -Dddocdir      write documentation file to docdir directory\n\
   -Dffilename    write documentation file to filename\n\
@@ -412,6 +450,11 @@ Usage:\n\
   -defaultlib=name  set default library to name\n\
   -deps          print module dependencies (imports/file/version/debug/lib)\n\
   -deps=filename write module dependencies to filename (only imports)\n%s\
+  -ftime-trace   write a Chrome trace event file of the compilation\n\
+  -ftime-trace-file=filename\n\
+                 write the trace to filename\n\
+  -ftime-trace-granularity=nnn\n\
+                 only trace events of nnn microseconds or more (default 500)\n\
   -g             add symbolic debug info\n\
   -gc            add symbolic debug info, pretend to be C\n\
   -gs            always emit stack frame\n\
@@ -423,6 +466,8 @@ Usage:\n\
   -Ipath         where to look for imports\n\
   -ignore        ignore unsupported pragmas\n\
   -inline        do function inlining\n\
+  -j             parse and generate code in parallel, one job per processor\n\
+  -j=nnn         parse and generate code in parallel using nnn jobs\n\
   -Jpath         where to look for string imports\n\
   -Llinkerflag   pass linkerflag to link\n\
   -lib           generate library rather than object files\n\
@@ -431,6 +476,7 @@ Usage:\n\
   -main          add default main() (e.g. for unittesting)\n\
   -man           open web browser on manual page\n\
   -map           generate linker .map file\n\
+  -mcpu=id       schedule 64 bit code for CPU id, default none (=? lists them)\n\
   -noboundscheck turns off array bounds checking for all functions\n\
   -O             optimize\n\
   -o-            do not write object file\n\
@@ -440,6 +486,7 @@ Usage:\n\
   -profile       profile runtime performance of generated code\n\
   -property      enforce property syntax\n\
   -quiet         suppress unnecessary messages\n\
+  -regsplit      split live ranges when assigning registers\n\
   -release       compile release version\n\
   -run srcfile args...   run resulting program, passing args\n\
   -shared        generate shared library (DLL)\n\
@@ -449,6 +496,7 @@ Usage:\n\
   -v             verbose\n\
   -version=level compile in version code >= level\n\
   -version=ident compile in version code identified by ident\n\
+  -vmem          print memory use after each compilation phase\n\
   -vtls          list all variables going into thread local storage\n\
   -w             warnings as errors (compilation will halt)\n\
   -wi            warnings as messages (compilation will continue)\n\
@@ -507,6 +555,295 @@ void genCmain(Scope *sc)
     rootHasMain = sc->module;
 }
 
+/************************************
+ * Read and parse the root modules on global.params.jobs threads.
+ * Each module numbers its generated identifiers from its own
+ * interleaved sequence, so the result does not depend on which
+ * thread parsed which module.
+ */
+
+struct ParseJobs
+{
+    Modules *modules;
+    AsyncRead *aw;
+    size_t base;                // generated id sequences start here
+    size_t *lastIds;            // highest generated id used by each module
+    MemStats *memstats;         // memory allocated for each module
+    bool *readFailed;           // the module's file could not be read
+};
+
+static void parseJob(void *ctx, size_t i)
+{
+    ParseJobs *pj = (ParseJobs *)ctx;
+    Module *m = (*pj->modules)[i];
+    size_t stride = pj->modules->dim;
+
+    Lexer::uniqueIdSequence.last = pj->base + i;
+    Lexer::uniqueIdSequence.stride = stride;
+    Identifier::sequence.last = pj->base + i;
+    Identifier::sequence.stride = stride;
+
+    if (pj->aw->read(i))
+        pj->readFailed[i] = true;       // fatal() is for the main thread
+    else
+    {
+        TimeTrace::begin();
+        m->parseSource();
+        TimeTrace::end("Parse module", m);
+    }
+
+    size_t last = Lexer::uniqueIdSequence.last;
+    if (last < Identifier::sequence.last)
+        last = Identifier::sequence.last;
+    pj->lastIds[i] = last;
+    mem.takeStats(&pj->memstats[i]);
+
+    // Whatever else runs on this thread uses the ordinary sequences
+    Lexer::uniqueIdSequence.stride = 1;
+    Identifier::sequence.stride = 1;
+}
+
+static void parseModules(Modules *modules, AsyncRead *aw)
+{
+    ParseJobs pj;
+    pj.modules = modules;
+    pj.aw = aw;
+    pj.base = Lexer::uniqueIdSequence.last;
+    if (pj.base < Identifier::sequence.last)
+        pj.base = Identifier::sequence.last;
+    pj.lastIds = (size_t *)mem.malloc(modules->dim * sizeof(size_t));
+    pj.memstats = (MemStats *)mem.malloc(modules->dim * sizeof(MemStats));
+    pj.readFailed = (bool *)mem.calloc(modules->dim, sizeof(bool));
+
+    Lexer::stringtableLock = Mutex::create();
+    diagnosticLock = Mutex::create();
+
+    WorkPool::run(modules->dim, global.params.jobs, &parseJob, &pj);
+
+    Mutex::dispose(diagnosticLock);
+    diagnosticLock = NULL;
+    Mutex::dispose(Lexer::stringtableLock);
+    Lexer::stringtableLock = NULL;
+
+    for (size_t i = 0; i < modules->dim; i++)
+    {
+        if (pj.readFailed[i])
+        {
+            error(Loc(), "cannot read file %s", (*modules)[i]->srcfile->name->toChars());
+            fatal();
+        }
+        if ((*modules)[i]->badEncoding)
+            fatal();                    // parseSource() printed the error
+    }
+
+    // Continue both sequences past everything the threads used
+    size_t last = pj.base;
+    for (size_t i = 0; i < modules->dim; i++)
+    {
+        if (last < pj.lastIds[i])
+            last = pj.lastIds[i];
+        mem.addStats(&pj.memstats[i]);
+    }
+    Lexer::uniqueIdSequence.last = last;
+    Lexer::uniqueIdSequence.stride = 1;
+    Identifier::sequence.last = last;
+    Identifier::sequence.stride = 1;
+    mem.free(pj.lastIds);
+    mem.free(pj.memstats);
+    mem.free(pj.readFailed);
+}
+
+/************************************
+ * Write the -ftime-trace file, named after srcname unless
+ * -ftime-trace-file was given.
+ */
+
+static void writeTimeTrace(const char *srcname)
+{
+    OutBuffer buf;
+    TimeTrace::write(&buf);
+
+    const char *name = global.params.timeTraceFile;
+    if (!name)
+        name = FileName::forceExt(FileName::name(srcname), "time-trace");
+    ensurePathToNameExists(Loc(), name);
+
+    File *tracefile = new File(name);
+    tracefile->setbuffer(buf.data, buf.offset);
+    tracefile->ref = 1;
+    writeFile(Loc(), tracefile);
+}
+
+/************************************
+ * Print the -ctfeprofile table, or write it to the
+ * -ctfeprofile= file as JSON.
+ */
+
+static void writeCtfeProfile()
+{
+    OutBuffer buf;
+    const char *name = global.params.ctfeProfileFile;
+    CtfeProfile::write(&buf, name != NULL);
+    if (!name)
+    {
+        fprintf(global.stdmsg, "%s", buf.peekString());
+        return;
+    }
+    ensurePathToNameExists(Loc(), name);
+
+    File *profilefile = new File(name);
+    profilefile->setbuffer(buf.data, buf.offset);
+    profilefile->ref = 1;
+    writeFile(Loc(), profilefile);
+}
+
+/************************************
+ * Print the memory held by each kind of allocation, for -vmem.
+ */
+
+static void printMemStats(const char *phase)
+{
+    static const char *names[MEMmax] =
+    {
+        "other", "tokens", "expressions", "types",
+        "dsymbols", "template instances", "ctfe values",
+    };
+
+    MemStats stats;
+    mem.takeStats(&stats);
+    mem.addStats(&stats);
+
+    size_t total = 0;
+    for (int i = 0; i < MEMmax; i++)
+        total += stats.bytes[i];
+    fprintf(global.stdmsg, "memory    %-10s %10u kB\n", phase, (unsigned)(total / 1024));
+    for (int i = 0; i < MEMmax; i++)
+    {
+        fprintf(global.stdmsg, "memory      %-18s %10u kB %10u objects\n", names[i],
+            (unsigned)(stats.bytes[i] / 1024), (unsigned)stats.objects[i]);
+    }
+
+    unsigned elems, peak;
+    size_t elemsize;
+    el_stats(&elems, &peak, &elemsize);
+    fprintf(global.stdmsg, "memory      %-18s %10u kB %10u objects, peak %u\n", "backend elems",
+        (unsigned)(elems * elemsize / 1024), elems, peak);
+}
+
+/************************************
+ * Generate the object file for module m, or hand it to library.
+ */
+
+static void genObjFile(Module *m, Library *library)
+{
+    if (global.params.verbose)
+        fprintf(global.stdmsg, "code      %s\n", m->toChars());
+    TimeTraceScope tts("Codegen module", m);
+    if (global.params.obj)
+    {
+        obj_start(m->srcfile->toChars());
+        m->genobjfile(global.params.multiobj);
+        if (entrypoint && m == rootHasMain)
+            entrypoint->genobjfile(global.params.multiobj);
+        obj_end(library, m->objfile);
+        obj_write_deferred(library);
+    }
+    if (global.errors)
+    {
+        if (!global.params.lib)
+            m->deleteObjFile();
+    }
+    else
+    {
+        if (global.params.doDocComments)
+            m->gendocfile();
+    }
+}
+
+/************************************
+ * Generate one object file per module on global.params.jobs processes.
+ * The backend keeps its per-function and per-object file state in
+ * globals, so rather than threads each worker is a fork()ed copy of
+ * the compiler after semantic analysis, and takes every jobs'th module.
+ * The calling process is worker 0.
+ * Returns false if no worker could be started, in which case nothing
+ * has been generated.
+ */
+
+static bool genObjFilesParallel(Modules *modules)
+{
+#if __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun
+    unsigned nworkers = global.params.jobs;
+    if (nworkers > modules->dim)
+        nworkers = (unsigned)modules->dim;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t *pids = (pid_t *)mem.malloc(nworkers * sizeof(pid_t));
+    unsigned nstarted = 1;
+    for (; nstarted < nworkers; nstarted++)
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+            break;              // make do with fewer workers
+        if (pid == 0)
+        {
+            for (size_t i = nstarted; i < modules->dim; i += nworkers)
+                genObjFile((*modules)[i], NULL);
+            fflush(stdout);
+            fflush(stderr);
+            _exit(global.errors ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+        pids[nstarted] = pid;
+    }
+    if (nstarted == 1)
+    {
+        mem.free(pids);
+        return false;
+    }
+
+    /* Modules that would have gone to workers that could not be
+     * started are done here as well.
+     */
+    for (size_t i = 0; i < modules->dim; i++)
+    {
+        if (i % nworkers == 0 || i % nworkers >= nstarted)
+            genObjFile((*modules)[i], NULL);
+    }
+
+    for (unsigned i = 1; i < nstarted; i++)
+    {
+        int status;
+        while (waitpid(pids[i], &status, 0) == -1)
+        {
+            if (errno != EINTR)
+            {
+                status = -1;
+                break;
+            }
+        }
+        if (status == -1 || !WIFEXITED(status))
+            error(Loc(), "code generation worker terminated abnormally");
+        else if (WEXITSTATUS(status) != EXIT_SUCCESS)
+            global.errors++;        // the worker printed the messages
+    }
+    mem.free(pids);
+
+    /* A failed worker only deleted its own object files;
+     * don't leave the others' behind.
+     */
+    if (global.errors)
+    {
+        for (size_t i = 0; i < modules->dim; i++)
+            (*modules)[i]->deleteObjFile();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 int tryMain(size_t argc, const char *argv[])
 {
     Strings files;
@@ -552,6 +889,8 @@ int tryMain(size_t argc, const char *argv[])
     global.params.useArrayBounds = 2;   // default to all functions
     global.params.useSwitchError = 1;
     global.params.useInline = 0;
+    global.params.jobs = 1;
+    global.params.timeTraceGranularity = 500;
     global.params.obj = 1;
     global.params.quiet = 1;
     global.params.useDeprecated = 2;
@@ -690,6 +1029,27 @@ int tryMain(size_t argc, const char *argv[])
                 goto Lerror;
 #endif
             }
+            else if (strcmp(p + 1, "ftime-trace") == 0)
+                global.params.timeTrace = 1;
+            else if (memcmp(p + 1, "ftime-trace-file=", 17) == 0)
+            {
+                global.params.timeTrace = 1;
+                global.params.timeTraceFile = p + 18;
+                if (!*global.params.timeTraceFile)
+                    goto Lnoarg;
+            }
+            else if (memcmp(p + 1, "ftime-trace-granularity=", 24) == 0)
+            {
+                long granularity;
+                if (!isdigit((utf8_t)p[25]))
+                    goto Lerror;
+                errno = 0;
+                granularity = strtol(p + 25, (char **)&p, 10);
+                if (*p || errno || granularity > UINT_MAX)
+                    goto Lerror;
+                global.params.timeTrace = 1;
+                global.params.timeTraceGranularity = (unsigned)granularity;
+            }
             else if (strcmp(p + 1, "fPIC") == 0)
             {
 #if TARGET_LINUX || TARGET_OSX || TARGET_FREEBSD || TARGET_OPENBSD || TARGET_SOLARIS
@@ -718,12 +1078,44 @@ int tryMain(size_t argc, const char *argv[])
                 global.params.is64bit = false;
             else if (strcmp(p + 1, "m64") == 0)
                 global.params.is64bit = true;
+            else if (memcmp(p + 1, "mcpu=", 5) == 0)
+            {
+                if (strcmp(p + 6, "?") == 0)
+                {
+                    printf("CPUs listed by -mcpu=id, used to schedule 64 bit code:\n");
+                    for (size_t j = 0; j < sizeof(mcpuNames) / sizeof(mcpuNames[0]); j++)
+                        printf("  =%s\n", mcpuNames[j]);
+                    return EXIT_FAILURE;
+                }
+                size_t j;
+                for (j = 0; j < sizeof(mcpuNames) / sizeof(mcpuNames[0]); j++)
+                {
+                    if (strcmp(p + 6, mcpuNames[j]) == 0)
+                        break;
+                }
+                if (j == sizeof(mcpuNames) / sizeof(mcpuNames[0]))
+                    goto Lerror;
+                global.params.mcpu = j;
+            }
             else if (strcmp(p + 1, "profile") == 0)
                 global.params.trace = 1;
             else if (strcmp(p + 1, "v") == 0)
                 global.params.verbose = 1;
             else if (strcmp(p + 1, "vtls") == 0)
                 global.params.vtls = 1;
+            else if (strcmp(p + 1, "vmem") == 0)
+                global.params.vmem = 1;
+            else if (strcmp(p + 1, "ctfememo") == 0)
+                global.params.ctfeMemo = true;
+            else if (strcmp(p + 1, "ctfeprofile") == 0)
+                global.params.ctfeProfile = true;
+            else if (memcmp(p + 1, "ctfeprofile=", 12) == 0)
+            {
+                global.params.ctfeProfile = true;
+                global.params.ctfeProfileFile = p + 13;
+                if (!*global.params.ctfeProfileFile)
+                    goto Lnoarg;
+            }
             else if (memcmp(p + 1, "transition", 10) == 0)
             {
                 // Parse:
@@ -879,6 +1271,28 @@ Language changes listed by -transition=id:\n\
                 global.params.enforcePropertySyntax = 1;
             else if (strcmp(p + 1, "inline") == 0)
                 global.params.useInline = 1;
+            else if (p[1] == 'j' && (p[2] == 0 || p[2] == '='))
+            {
+                // Parse:
+                //      -j
+                //      -j=nnn
+                if (p[2] == '=')
+                {
+                    if (isdigit((utf8_t)p[3]))
+                    {   long jobs;
+
+                        errno = 0;
+                        jobs = strtol(p + 3, (char **)&p, 10);
+                        if (*p || errno || jobs < 1 || jobs > 1024)
+                            goto Lerror;
+                        global.params.jobs = (unsigned)jobs;
+                    }
+                    else
+                        goto Lerror;
+                }
+                else
+                    global.params.jobs = Thread::numProcessors();
+            }
             else if (strcmp(p + 1, "lib") == 0)
                 global.params.lib = 1;
             else if (strcmp(p + 1, "nofloat") == 0)
@@ -887,6 +1301,8 @@ Language changes listed by -transition=id:\n\
                 global.params.quiet = 1;
             else if (strcmp(p + 1, "release") == 0)
                 global.params.release = 1;
+            else if (strcmp(p + 1, "regsplit") == 0)
+                global.params.regsplit = true;
             else if (strcmp(p + 1, "betterC") == 0)
                 global.params.betterC = 1;
             else if (strcmp(p + 1, "noboundscheck") == 0)
@@ -1092,6 +1508,9 @@ Language changes listed by -transition=id:\n\
         return EXIT_FAILURE;
     }
 
+    if (global.params.timeTrace)
+        TimeTrace::start(global.params.timeTraceGranularity);
+
     if (!setdebuglib)
         global.params.debuglibname = global.params.defaultlibname;
 
@@ -1407,6 +1826,8 @@ Language changes listed by -transition=id:\n\
         }
     }
 
+    TimeTrace::begin();
+
 #define ASYNCREAD 1
 #if ASYNCREAD
     // Multi threaded
@@ -1417,6 +1838,13 @@ Language changes listed by -transition=id:\n\
         aw->addFile(m->srcfile);
     }
     aw->start();
+
+    bool parsed = false;
+    if (global.params.jobs > 1 && modules.dim > 1)
+    {
+        parseModules(&modules, aw);
+        parsed = true;
+    }
 #else
     // Single threaded
     for (size_t i = 0; i < modules.dim; i++)
@@ -1440,13 +1868,25 @@ Language changes listed by -transition=id:\n\
         if (!global.params.oneobj || modi == 0 || m->isDocFile)
             m->deleteObjFile();
 #if ASYNCREAD
-        if (aw->read(filei))
+        if (parsed)
         {
-            error(Loc(), "cannot read file %s", m->srcfile->name->toChars());
-            fatal();
+            if (!m->isDocFile)
+                m->addToModules();
         }
-#endif
+        else
+        {
+            if (aw->read(filei))
+            {
+                error(Loc(), "cannot read file %s", m->srcfile->name->toChars());
+                fatal();
+            }
+            TimeTrace::begin();
+            m->parse();
+            TimeTrace::end("Parse module", m);
+        }
+#else
         m->parse();
+#endif
         if (m->isDocFile)
         {
             anydocfiles = true;
@@ -1473,6 +1913,9 @@ Language changes listed by -transition=id:\n\
 #if ASYNCREAD
     AsyncRead::dispose(aw);
 #endif
+    TimeTrace::end("Parse");
+    if (global.params.vmem)
+        printMemStats("parse");
 
     if (anydocfiles && modules.dim &&
         (global.params.oneobj || global.params.objname))
@@ -1501,24 +1944,31 @@ Language changes listed by -transition=id:\n\
         fatal();
 
     // load all unconditional imports for better symbol resolving
+    TimeTrace::begin();
     for (size_t i = 0; i < modules.dim; i++)
     {
        Module *m = modules[i];
        if (global.params.verbose)
            fprintf(global.stdmsg, "importall %s\n", m->toChars());
+       TimeTraceScope tts("Import all module", m);
        m->importAll(NULL);
     }
+    TimeTrace::end("Import all");
+    if (global.params.vmem)
+        printMemStats("importall");
     if (global.errors)
         fatal();
 
     backend_init();
 
     // Do semantic analysis
+    TimeTrace::begin();
     for (size_t i = 0; i < modules.dim; i++)
     {
         Module *m = modules[i];
         if (global.params.verbose)
             fprintf(global.stdmsg, "semantic  %s\n", m->toChars());
+        TimeTraceScope tts("Semantic1 module", m);
         m->semantic();
     }
     if (global.errors)
@@ -1526,24 +1976,34 @@ Language changes listed by -transition=id:\n\
 
     Module::dprogress = 1;
     Module::runDeferredSemantic();
+    TimeTrace::end("Semantic1");
+    if (global.params.vmem)
+        printMemStats("semantic");
 
     // Do pass 2 semantic analysis
+    TimeTrace::begin();
     for (size_t i = 0; i < modules.dim; i++)
     {
         Module *m = modules[i];
         if (global.params.verbose)
             fprintf(global.stdmsg, "semantic2 %s\n", m->toChars());
+        TimeTraceScope tts("Semantic2 module", m);
         m->semantic2();
     }
+    TimeTrace::end("Semantic2");
+    if (global.params.vmem)
+        printMemStats("semantic2");
     if (global.errors)
         fatal();
 
     // Do pass 3 semantic analysis
+    TimeTrace::begin();
     for (size_t i = 0; i < modules.dim; i++)
     {
         Module *m = modules[i];
         if (global.params.verbose)
             fprintf(global.stdmsg, "semantic3 %s\n", m->toChars());
+        TimeTraceScope tts("Semantic3 module", m);
         m->semantic3();
     }
     if (global.errors)
@@ -1565,6 +2025,7 @@ Language changes listed by -transition=id:\n\
                 Module *m = Module::amodules[i];
                 if (global.params.verbose)
                     fprintf(global.stdmsg, "semantic3 %s\n", m->toChars());
+                TimeTraceScope tts("Semantic3 module", m);
                 m->semantic3();
             }
             if (global.errors)
@@ -1572,9 +2033,19 @@ Language changes listed by -transition=id:\n\
         }
     }
     Module::runDeferredSemantic3();
+    TimeTrace::end("Semantic3");
+    if (global.params.vmem)
+        printMemStats("semantic3");
     if (global.errors)
         fatal();
 
+    if (global.params.verbose)
+    {
+        DirCacheStats *dcs = &FileName::dirCacheStats;
+        fprintf(global.stdmsg, "dircache  %u lookups in %u directories, %u stat calls avoided\n",
+            dcs->lookups, dcs->dirs, dcs->lookups - dcs->stats);
+    }
+
     if (global.params.moduleDeps)
     {
         OutBuffer* ob = global.params.moduleDeps;
@@ -1591,15 +2062,23 @@ Language changes listed by -transition=id:\n\
     // Scan for functions to inline
     if (global.params.useInline)
     {
+        TimeTrace::begin();
         for (size_t i = 0; i < modules.dim; i++)
         {
             Module *m = modules[i];
             if (global.params.verbose)
                 fprintf(global.stdmsg, "inline scan %s\n", m->toChars());
+            TimeTraceScope tts("Inline module", m);
             m->inlineScan();
         }
+        TimeTrace::end("Inline");
+        if (global.params.vmem)
+            printMemStats("inline");
     }
 
+    if (global.params.ctfeProfile)
+        writeCtfeProfile();
+
     // Do not attempt to generate output files if errors or warnings occurred
     if (global.errors || global.warnings)
         fatal();
@@ -1668,6 +2147,7 @@ Language changes listed by -transition=id:\n\
         }
     }
 
+    TimeTrace::begin();
     if (global.params.oneobj)
     {
         if (modules.dim)
@@ -1677,6 +2157,7 @@ Language changes listed by -transition=id:\n\
             Module *m = modules[i];
             if (global.params.verbose)
                 fprintf(global.stdmsg, "code      %s\n", m->toChars());
+            TimeTraceScope tts("Codegen module", m);
             m->genobjfile(0);
             if (entrypoint && m == rootHasMain)
                 entrypoint->genobjfile(0);
@@ -1690,36 +2171,29 @@ Language changes listed by -transition=id:\n\
     }
     else
     {
-        for (size_t i = 0; i < modules.dim; i++)
+        bool generated = false;
+        /* -v and -vmem report counters the workers would keep to themselves,
+         * so they generate code serially.
+         */
+        if (global.params.jobs > 1 && modules.dim > 1 && !TimeTrace::enabled &&
+            !global.params.verbose && !global.params.vmem &&
+            global.params.obj && !global.params.lib && !global.params.multiobj)
+            generated = genObjFilesParallel(&modules);
+        if (!generated)
         {
-            Module *m = modules[i];
-            if (global.params.verbose)
-                fprintf(global.stdmsg, "code      %s\n", m->toChars());
-            if (global.params.obj)
-            {
-                obj_start(m->srcfile->toChars());
-                m->genobjfile(global.params.multiobj);
-                if (entrypoint && m == rootHasMain)
-                    entrypoint->genobjfile(global.params.multiobj);
-                obj_end(library, m->objfile);
-                obj_write_deferred(library);
-            }
-            if (global.errors)
-            {
-                if (!global.params.lib)
-                    m->deleteObjFile();
-            }
-            else
-            {
-                if (global.params.doDocComments)
-                    m->gendocfile();
-            }
+            for (size_t i = 0; i < modules.dim; i++)
+                genObjFile(modules[i], library);
         }
     }
 
     if (global.params.lib && !global.errors)
         library->write();
 
+    TimeTrace::end("Codegen");
+    if (global.params.vmem)
+        printMemStats("codegen");
+    if (TimeTrace::enabled)
+        writeTimeTrace(modules.dim ? modules[0]->srcfile->toChars() : files[0]);
     backend_term();
     if (global.errors)
         fatal();
@@ -95,10 +95,12 @@ struct Param
     char quiet;         // suppress non-error messages
     char verbose;       // verbose compile
     char vtls;          // identify thread local variables
+    char vmem;          // print memory use after each phase
     char vfield;        // identify non-mutable field variables
     char symdebug;      // insert debug symbolic information
     bool alwaysframe;   // always emit standard stack frame
     bool optimize;      // run optimizer
+    bool regsplit;      // split live ranges of register variables
     char map;           // generate linker .map file
     bool is64bit;       // generate 64 bit code
     char isLP64;        // generate code for LP64
@@ -109,6 +111,7 @@ struct Param
     char isOpenBSD;     // generate code for OpenBSD
     char isSolaris;     // generate code for Solaris
     char scheduler;     // which scheduler to use
+    unsigned char mcpu; // -mcpu=, MODELxxx processor to schedule 64 bit code for
     char useDeprecated; // 0: don't allow use of deprecated features
                         // 1: silently allow use of deprecated features
                         // 2: warn about the use of deprecated features
@@ -138,6 +141,13 @@ struct Param
     char betterC;       // be a "better C" compiler; no dependency on D runtime
     bool addMain;       // add a default main() function
     bool allInst;       // generate code for all template instantiations
+    unsigned jobs;      // number of threads to parse source files with
+    char timeTrace;     // write a trace event file of where the time went
+    unsigned timeTraceGranularity;      // drop events shorter than this many microseconds
+    const char *timeTraceFile;          // where to write it
+    bool ctfeMemo;      // reuse the results of strongly pure CTFE calls
+    bool ctfeProfile;   // record the calls CTFE makes and what they cost
+    const char *ctfeProfileFile;        // write them to it as JSON, instead of printing a table
 
     const char *argv0;    // program name
     Strings *imppath;     // array of char*'s of where to look for import modules
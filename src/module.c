@@ -22,6 +22,7 @@
 #include "dsymbol.h"
 #include "hdrgen.h"
 #include "lexer.h"
+#include "aav.h"
 
 #ifdef IN_GCC
 #include "d-dmd-gcc.h"
@@ -32,11 +33,24 @@ AggregateDeclaration *Module::moduleinfo;
 Module *Module::rootModule;
 DsymbolTable *Module::modules;
 Modules Module::amodules;
+unsigned Module::searchDepth = 1;       // above the insearch imports() leaves behind
+unsigned Module::searchCutoff = ~0u;
 
 Dsymbols Module::deferred; // deferred Dsymbol's needing semantic() run on them
 Dsymbols Module::deferred3;
 unsigned Module::dprogress;
 
+/* For each Dsymbol ever put in deferred, a DeferredState:
+ * whether it is in deferred now, and the deferredProgress
+ * count when semantic() was last tried on it.
+ */
+static AA *deferredState;
+static AA *deferred3Set;        // Dsymbol's in deferred3
+static size_t deferredProgress = 1;     // counts progress on the deferred list
+
+#define DEFERRED_IN     1               // in deferred
+#define DEFERRED_TRIED(st)  ((size_t)(st) >> 1) // deferredProgress when last tried
+
 const char *lookForSourceFile(const char *filename);
 
 void Module::init()
@@ -57,6 +71,7 @@ Module::Module(const char *filename, Identifier *ident, int doDocComment, int do
     numlines = 0;
     members = NULL;
     isDocFile = 0;
+    badEncoding = false;
     needmoduleinfo = 0;
     selfimports = 0;
     insearch = 0;
@@ -258,7 +273,7 @@ Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
 bool Module::read(Loc loc)
 {
     //printf("Module::read('%s') file '%s'\n", toChars(), srcfile->toChars());
-    if (srcfile->read())
+    if (srcfile->mmread())
     {
         if (!strcmp(srcfile->toChars(), "object.d"))
         {
@@ -327,9 +342,24 @@ inline unsigned readlongBE(unsigned *p)
 void Module::parse()
 {
     //printf("Module::parse()\n");
+    parseSource();
+    if (badEncoding)
+        fatal();
+    if (!isDocFile)
+        addToModules();
+}
 
-    char *srcname = srcfile->name->toChars();
-    //printf("Module::parse(srcname = '%s')\n", srcname);
+/**************************************
+ * Convert the source text to UTF-8 and parse it into members.
+ * Only touches this module and thread safe parts of the front end,
+ * so different modules can be parsed concurrently.
+ * If the source can't be converted, the error is printed and
+ * badEncoding set, leaving it to the caller to call fatal().
+ */
+
+void Module::parseSource()
+{
+    //printf("Module::parseSource(srcname = '%s')\n", srcfile->name->toChars());
 
     utf8_t *buf = (utf8_t *)srcfile->buffer;
     size_t buflen = srcfile->len;
@@ -360,7 +390,8 @@ void Module::parse()
 
                 if (buflen & 3)
                 {   error("odd length of UTF-32 char source %u", buflen);
-                    fatal();
+                    badEncoding = true;
+                    return;
                 }
 
                 dbuf.reserve(buflen / 4);
@@ -372,7 +403,8 @@ void Module::parse()
                     {
                         if (u > 0x10FFFF)
                         {   error("UTF-32 value %08x greater than 0x10FFFF", u);
-                            fatal();
+                            badEncoding = true;
+                            return;
                         }
                         dbuf.writeUTF8(u);
                     }
@@ -395,7 +427,8 @@ void Module::parse()
 
                 if (buflen & 1)
                 {   error("odd length of UTF-16 char source %u", buflen);
-                    fatal();
+                    badEncoding = true;
+                    return;
                 }
 
                 dbuf.reserve(buflen / 2);
@@ -409,23 +442,27 @@ void Module::parse()
 
                             if (++pu > pumax)
                             {   error("surrogate UTF-16 high value %04x at EOF", u);
-                                fatal();
+                                badEncoding = true;
+                                return;
                             }
                             u2 = le ? readwordLE(pu) : readwordBE(pu);
                             if (u2 < 0xDC00 || u2 > 0xDFFF)
                             {   error("surrogate UTF-16 low value %04x out of range", u2);
-                                fatal();
+                                badEncoding = true;
+                                return;
                             }
                             u = (u - 0xD7C0) << 10;
                             u |= (u2 - 0xDC00);
                         }
                         else if (u >= 0xDC00 && u <= 0xDFFF)
                         {   error("unpaired surrogate UTF-16 value %04x", u);
-                            fatal();
+                            badEncoding = true;
+                            return;
                         }
                         else if (u == 0xFFFE || u == 0xFFFF)
                         {   error("illegal UTF-16 value %04x", u);
-                            fatal();
+                            badEncoding = true;
+                            return;
                         }
                         dbuf.writeUTF8(u);
                     }
@@ -490,7 +527,8 @@ void Module::parse()
             // It's UTF-8
             if (buf[0] >= 0x80)
             {   error("source file must start with BOM or ASCII character, not \\x%02X", buf[0]);
-                fatal();
+                badEncoding = true;
+                return;
             }
         }
     }
@@ -514,10 +552,17 @@ void Module::parse()
         numlines = p.scanloc.linnum;
     }
 
-    if (srcfile->ref == 0)
-        ::free(srcfile->buffer);
-    srcfile->buffer = NULL;
-    srcfile->len = 0;
+    srcfile->freeData();
+}
+
+/**************************************
+ * Insert the parsed module into the package tree and the list
+ * of all modules.
+ */
+
+void Module::addToModules()
+{
+    char *srcname = srcfile->name->toChars();
 
     /* The symbol table into which the module is to be inserted.
      */
@@ -878,17 +923,23 @@ Dsymbol *Module::search(Loc loc, Identifier *ident, int flags)
 {
     /* Since modules can be circularly referenced,
      * need to stop infinite recursive searches.
-     * This is done with the cache.
+     * This is done with insearch, and the searches cut short
+     * by it are not cached.
      */
 
     //printf("%s Module::search('%s', flags = %d) insearch = %d\n", toChars(), ident->toChars(), flags, insearch);
     Dsymbol *s;
     if (insearch)
+    {
+        if ((unsigned)insearch < searchCutoff)
+            searchCutoff = insearch;
         s = NULL;
+    }
     else
     {
-        insearch = 1;
+        insearch = ++searchDepth;
         s = ScopeDsymbol::search(loc, ident, flags);
+        searchDepth--;
         insearch = 0;
     }
     return s;
@@ -901,21 +952,23 @@ Dsymbol *Module::search(Loc loc, Identifier *ident, int flags)
 void Module::addDeferredSemantic(Dsymbol *s)
 {
     // Don't add it if it is already there
-    for (size_t i = 0; i < deferred.dim; i++)
-    {
-        Dsymbol *sd = deferred[i];
-
-        if (sd == s)
-            return;
-    }
+    size_t *pst = (size_t *)_aaGet(&deferredState, s);
+    if (*pst & DEFERRED_IN)
+        return;
 
     //printf("Module::addDeferredSemantic('%s')\n", s->toChars());
+    *pst |= DEFERRED_IN;
     deferred.push(s);
 }
 
 
 /******************************************
  * Run semantic() on deferred symbols.
+ * Progress is when a symbol is no longer deferred after semantic(),
+ * or when dprogress goes up. A symbol that was tried after the last
+ * progress is not tried again, as nothing it could be waiting on has
+ * changed, until a pass over the rest makes no progress. Then all of
+ * them get one last try.
  */
 
 void Module::runDeferredSemantic()
@@ -929,41 +982,55 @@ void Module::runDeferredSemantic()
     //if (deferred.dim) printf("+Module::runDeferredSemantic(), len = %d\n", deferred.dim);
     nested++;
 
-    size_t len;
-    do
+    static Dsymbols todo;
+    deferredProgress++;         // progress was made outside of the list
+    bool tryall = false;
+    while (1)
     {
         dprogress = 0;
-        len = deferred.dim;
+        size_t len = deferred.dim;
         if (!len)
             break;
 
-        Dsymbol **todo;
-        Dsymbol **todoalloc = NULL;
-        Dsymbol *tmp;
-        if (len == 1)
-        {
-            todo = &tmp;
-        }
-        else
-        {
-            todo = (Dsymbol **)malloc(len * sizeof(Dsymbol *));
-            assert(todo);
-            todoalloc = todo;
-        }
-        memcpy(todo, deferred.tdata(), len * sizeof(Dsymbol *));
+        todo.setDim(0);
+        todo.append(&deferred);
         deferred.setDim(0);
 
+        bool progress = false;
+        bool skipped = false;
         for (size_t i = 0; i < len; i++)
         {
             Dsymbol *s = todo[i];
+            size_t *pst = (size_t *)_aaGet(&deferredState, s);
+
+            if (!tryall && DEFERRED_TRIED(*pst) == deferredProgress)
+            {
+                // Nothing changed since it was last tried
+                deferred.push(s);
+                skipped = true;
+                continue;
+            }
+            *pst = deferredProgress << 1;
+            unsigned dprogress_save = dprogress;
 
             s->semantic(NULL);
             //printf("deferred: %s, parent = %s\n", s->toChars(), s->parent->toChars());
+
+            pst = (size_t *)_aaGet(&deferredState, s);
+            if (!(*pst & DEFERRED_IN) || dprogress > dprogress_save)
+            {
+                deferredProgress++;
+                progress = true;
+            }
         }
         //printf("\tdeferred.dim = %d, len = %d, dprogress = %d\n", deferred.dim, len, dprogress);
-        if (todoalloc)
-            free(todoalloc);
-    } while (deferred.dim < len || dprogress);  // while making progress
+        if (progress)
+            tryall = false;
+        else if (skipped && !tryall)
+            tryall = true;
+        else
+            break;
+    }
     nested--;
     //printf("-Module::runDeferredSemantic(), len = %d\n", deferred.dim);
 }
@@ -971,12 +1038,10 @@ void Module::runDeferredSemantic()
 void Module::addDeferredSemantic3(Dsymbol *s)
 {
     // Don't add it if it is already there
-    for (size_t i = 0; i < deferred3.dim; i++)
-    {
-        Dsymbol *sd = deferred3[i];
-        if (sd == s)
-            return;
-    }
+    Dsymbol **ps = (Dsymbol **)_aaGet(&deferred3Set, s);
+    if (*ps)
+        return;
+    *ps = s;
     deferred3.push(s);
 }
 
@@ -1197,21 +1262,21 @@ const char *lookForSourceFile(const char *filename)
      */
 
     const char *sdi = FileName::forceExt(filename, global.hdr_ext);
-    if (FileName::exists(sdi) == 1)
+    if (FileName::existsCached(sdi) == 1)
         return sdi;
 
     const char *sd  = FileName::forceExt(filename, global.mars_ext);
-    if (FileName::exists(sd) == 1)
+    if (FileName::existsCached(sd) == 1)
         return sd;
 
-    if (FileName::exists(filename) == 2)
+    if (FileName::existsCached(filename) == 2)
     {
         /* The filename exists and it's a directory.
          * Therefore, the result should be: filename/package.d
          * iff filename/package.d is a file
          */
         const char *n = FileName::combine(filename, "package.d");
-        if (FileName::exists(n) == 1)
+        if (FileName::existsCached(n) == 1)
             return n;
         FileName::free(n);
     }
@@ -1227,22 +1292,22 @@ const char *lookForSourceFile(const char *filename)
         const char *p = (*global.path)[i];
 
         const char *n = FileName::combine(p, sdi);
-        if (FileName::exists(n) == 1)
+        if (FileName::existsCached(n) == 1)
             return n;
         FileName::free(n);
 
         n = FileName::combine(p, sd);
-        if (FileName::exists(n) == 1)
+        if (FileName::existsCached(n) == 1)
             return n;
         FileName::free(n);
 
         const char *b = FileName::removeExt(filename);
         n = FileName::combine(p, b);
         FileName::free(b);
-        if (FileName::exists(n) == 2)
+        if (FileName::existsCached(n) == 2)
         {
             const char *n2 = FileName::combine(n, "package.d");
-            if (FileName::exists(n2) == 1)
+            if (FileName::existsCached(n2) == 1)
                 return n2;
             FileName::free(n2);
         }
@@ -81,12 +81,15 @@ public:
     unsigned errors;    // if any errors in file
     unsigned numlines;  // number of lines in source file
     int isDocFile;      // if it is a documentation input file, not D source
+    bool badEncoding;   // if parseSource() couldn't convert the source to UTF-8
     int needmoduleinfo;
 
     int selfimports;            // 0: don't know, 1: does not, 2: does
     int selfImports();          // returns !=0 if module imports itself
 
-    int insearch;
+    int insearch;               // depth of the search() in progress, 1 from imports()
+    static unsigned searchDepth;    // of the innermost search() in progress
+    static unsigned searchCutoff;   // least insearch of the modules skipped
 
     Module *importedFrom;       // module from command line we're imported from,
                                 // i.e. a module that will be taken all the
@@ -122,6 +125,8 @@ public:
     void setDocfile();
     bool read(Loc loc); // read file, returns 'true' if succeed, 'false' otherwise.
     void parse();       // syntactic parse
+    void parseSource(); // lex and parse only, safe to run in parallel
+    void addToModules(); // enter parsed module into the symbol tables
     void importAll(Scope *sc);
     void semantic();    // semantic analysis
     void semantic2();   // pass 2 semantic analysis
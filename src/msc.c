@@ -21,6 +21,7 @@
 #include        "type.h"
 #include        "dt.h"
 #include        "cgcv.h"
+#include        "go.h"
 
 static char __file__[] = __FILE__;      /* for tassert.h                */
 #include        "tassert.h"
@@ -87,6 +88,7 @@ void backend_init()
     exe = params->pic == 0;
 #endif
 
+    config.target_model = params->mcpu;
     out_config_init(
         params->is64bit ? 64 : 32,
         exe,
@@ -98,6 +100,8 @@ void backend_init()
         params->alwaysframe,
         params->stackstomp
     );
+    if (params->regsplit)
+        config.flags4 |= CFG4regsplit;
 
 #ifdef DEBUG
     out_config_debug(
@@ -171,4 +175,12 @@ symbol *symboldata(targ_size_t offset,tym_t ty)
 
 void backend_term()
 {
+    if (global.params.verbose && global.params.optimize)
+    {
+        static const char *names[] = { "rd", "ae", "cp", "lv", "vbe" };
+        FlowStats *stats[] = { &rdstats, &aestats, &cpstats, &lvstats, &vbestats };
+        for (size_t i = 0; i < 5; i++)
+            fprintf(global.stdmsg, "dataflow  %-3s %u passes, %u blocks\n",
+                names[i], stats[i]->passes, stats[i]->blocks);
+    }
 }
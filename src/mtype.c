@@ -42,6 +42,7 @@
 #include "import.h"
 #include "aggregate.h"
 #include "hdrgen.h"
+#include "ctfe.h"
 
 FuncDeclaration *hasThis(Scope *sc);
 void sizeToCBuffer(OutBuffer *buf, HdrGenState *hgs, Expression *e);
@@ -125,6 +126,10 @@ unsigned char Type::mangleChar[TMAX];
 unsigned char Type::sizeTy[TMAX];
 StringTable Type::stringtable;
 
+void *Type::operator new(size_t size)
+{
+    return mem.allocate(MEMtype, size);
+}
 
 Type::Type(TY ty)
 {
@@ -154,7 +159,7 @@ const char *Type::kind()
 
 Type *Type::copy()
 {
-    Type *t = (Type *)mem.malloc(sizeTy[ty]);
+    Type *t = (Type *)operator new(sizeTy[ty]);
     memcpy((void*)t, (void*)this, sizeTy[ty]);
     return t;
 }
@@ -393,7 +398,7 @@ Type *Type::trySemantic(Loc loc, Scope *sc)
 Type *Type::nullAttributes()
 {
     unsigned sz = sizeTy[ty];
-    Type *t = (Type *)mem.malloc(sz);
+    Type *t = (Type *)operator new(sz);
     memcpy((void*)t, (void*)this, sz);
     // t->mod = NULL;  // leave mod unchanged
     t->deco = NULL;
@@ -1264,6 +1269,7 @@ Type *Type::arrayOf()
 Type *Type::sarrayOf(dinteger_t dim)
 {
     assert(deco);
+    CtfeRegionSuspend crs;     // the type is kept
     Type *t = new TypeSArray(this, new IntegerExp(Loc(), dim, Type::tindex));
 
     // according to TypeSArray::semantic()
@@ -227,6 +227,7 @@ public:
     static unsigned char impcnvWarn[TMAX][TMAX];
 
     Type(TY ty);
+    static void *operator new(size_t sz);
     virtual const char *kind();
     Type *copy();
     virtual Type *syntaxCopy();
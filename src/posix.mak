@@ -71,7 +71,7 @@ DMD_OBJS = \
 	version.o strtold.o utf.o staticassert.o \
 	entity.o doc.o macro.o \
 	hdrgen.o delegatize.o interpret.o traits.o \
-	builtin.o ctfeexpr.o clone.o aliasthis.o \
+	builtin.o ctfeexpr.o ctfevm.o clone.o aliasthis.o \
 	arrayop.o async.o json.o unittests.o \
 	imphint.o argtypes.o apply.o sapply.o sideeffect.o \
 	intrange.o canthrow.o target.o
@@ -79,7 +79,7 @@ DMD_OBJS = \
 ROOT_OBJS = \
 	rmem.o port.o man.o stringtable.o response.o \
 	aav.o speller.o outbuffer.o object.o \
-	filename.o file.o
+	filename.o file.o thread.o timetrace.o
 
 GLUE_OBJS = \
 	glue.o msc.o s2ir.o todt.o e2ir.o tocsym.o \
@@ -132,7 +132,7 @@ SRC = win32.mak posix.mak osmodel.mak \
 	argtypes.c apply.c sapply.c sideeffect.c \
 	intrange.h intrange.c canthrow.c target.c target.h \
 	scanmscoff.c scanomf.c ctfe.h ctfeexpr.c \
-	ctfe.h ctfeexpr.c visitor.h
+	ctfe.h ctfeexpr.c ctfevm.c visitor.h
 
 ROOT_SRC = $(ROOT)/root.h \
 	$(ROOT)/array.h \
@@ -146,7 +146,9 @@ ROOT_SRC = $(ROOT)/root.h \
 	$(ROOT)/outbuffer.h $(ROOT)/outbuffer.c \
 	$(ROOT)/object.h $(ROOT)/object.c \
 	$(ROOT)/filename.h $(ROOT)/filename.c \
-	$(ROOT)/file.h $(ROOT)/file.c
+	$(ROOT)/file.h $(ROOT)/file.c \
+	$(ROOT)/thread.h $(ROOT)/thread.c \
+	$(ROOT)/timetrace.h $(ROOT)/timetrace.c
 
 GLUE_SRC = glue.c msc.c s2ir.c todt.c e2ir.c tocsym.c \
 	toobj.c toctype.c tocvdebug.c toir.h toir.c \
@@ -365,6 +367,9 @@ constfold.o: constfold.c
 ctfeexpr.o: ctfeexpr.c
 	$(CC) -c $(CFLAGS) $<
 
+ctfevm.o: ctfevm.c
+	$(CC) -c $(CFLAGS) $<
+
 irstate.o: irstate.c
 	$(CC) -c $(MFLAGS) -I$(ROOT) $<
 
@@ -644,6 +649,12 @@ ti_achar.o: $C/ti_achar.c
 ti_pvoid.o: $C/ti_pvoid.c
 	$(CC) -c $(MFLAGS) -I. $<
 
+thread.o: $(ROOT)/thread.c
+	$(CC) -c $(GFLAGS) -I$(ROOT) $<
+
+timetrace.o: $(ROOT)/timetrace.c
+	$(CC) -c $(GFLAGS) -I$(ROOT) $<
+
 tk.o: tk.c
 	$(CC) -c $(MFLAGS) $<
 
@@ -736,6 +747,7 @@ gcov:
 	gcov inline.c
 	gcov interpret.c
 	gcov ctfeexpr.c
+	gcov ctfevm.c
 	gcov irstate.c
 	gcov json.c
 	gcov lexer.c
@@ -134,6 +134,34 @@ Value _aaGetRvalue(AA* aa, Key key)
 }
 
 
+/*************************************************
+ * Remove the entry for key from associative array.
+ * Returns true if it was there.
+ */
+
+bool _aaDel(AA* aa, Key key)
+{
+    if (aa)
+    {
+        size_t i = hash((size_t)key) & (aa->b_length - 1);
+        aaA** pe = &aa->b[i];
+        aaA *e;
+        while ((e = *pe) != NULL)
+        {
+            if (key == e->key)
+            {   *pe = e->next;
+                aa->nodes--;
+                if (e != &aa->aafirst)
+                    delete e;
+                return true;
+            }
+            pe = &e->next;
+        }
+    }
+    return false;
+}
+
+
 /********************************************
  * Rehash an array.
  */
@@ -186,6 +214,9 @@ void unittest_aa()
     *pv = (void *)3;
     v = _aaGetRvalue(aa, NULL);
     assert(v == (void *)3);
+    assert(_aaDel(aa, NULL));
+    assert(!_aaGetRvalue(aa, NULL));
+    assert(!_aaDel(aa, NULL));
 }
 
 #endif
@@ -15,5 +15,6 @@ struct AA;
 size_t _aaLen(AA* aa);
 Value* _aaGet(AA** aa, Key key);
 Value _aaGetRvalue(AA* aa, Key key);
+bool _aaDel(AA* aa, Key key);
 void _aaRehash(AA** paa);
 
@@ -112,7 +112,7 @@ unsigned __stdcall startthread(void *p)
     for (size_t i = 0; i < aw->filesdim; i++)
     {   FileData *f = &aw->files[i];
 
-        f->result = f->file->read();
+        f->result = f->file->mmread();
         SetEvent(f->event);
     }
     _endthreadex(EXIT_SUCCESS);
@@ -247,7 +247,7 @@ void *startthread(void *p)
     for (size_t i = 0; i < dim; i++)
     {   FileData *f = &aw->files[i];
 
-        f->result = f->file->read();
+        f->result = f->file->mmread();
 
         // Set event
         int status = pthread_mutex_lock(&f->mutex);
@@ -321,7 +321,7 @@ void AsyncRead::start()
 int AsyncRead::read(size_t i)
 {
     FileData *f = &files[i];
-    f->result = f->file->read();
+    f->result = f->file->mmread();
     return f->result;
 }
 
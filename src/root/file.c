@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <utime.h>
+#include <sys/mman.h>
 #endif
 
 #include "filename.h"
@@ -64,6 +65,31 @@ File::File(const char *n)
 }
 
 File::~File()
+{
+    freeData();
+    if (touchtime)
+        mem.free(touchtime);
+}
+
+#if POSIX
+/*************************************
+ * Size of the mapping mmread() makes for a file of len bytes:
+ * the file plus the 2 byte sentinel, rounded up to whole pages.
+ */
+
+static size_t mapSize(size_t len)
+{
+    size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+    return (len + 2 + pagesize - 1) & ~(pagesize - 1);
+}
+#endif
+
+/*************************************
+ * Release the buffer, however it was obtained.
+ * A buffer that is a reference to someone else's is left alone.
+ */
+
+void File::freeData()
 {
     if (buffer)
     {
@@ -72,10 +98,15 @@ File::~File()
 #if _WIN32
         if (ref == 2)
             UnmapViewOfFile(buffer);
+#endif
+#if POSIX
+        if (ref == 2)
+            munmap(buffer, mapSize(len));
 #endif
     }
-    if (touchtime)
-        mem.free(touchtime);
+    ref = 0;
+    buffer = NULL;
+    len = 0;
 }
 
 /*************************************
@@ -214,16 +245,68 @@ err1:
 
 /*****************************
  * Read a file with memory mapped file I/O.
+ * The buffer is read only, and like read() it is followed by
+ * two 0 bytes as a sentinel for the scanner.
+ * Falls back to read() for files that can't be mapped.
  */
 
 int File::mmread()
 {
+    if (len)
+        return 0;               // already read the file
 #if POSIX
+    struct stat buf;
+    size_t size;
+    size_t maplen;
+    void *p;
+    char *name;
+
+    name = this->name->toChars();
+    //printf("File::mmread('%s')\n",name);
+    int fd = open(name, O_RDONLY);
+    if (fd == -1)
+        return 1;
+
+    if (fstat(fd, &buf) || !S_ISREG(buf.st_mode) || buf.st_size == 0)
+        goto Lread;
+    size = (size_t)buf.st_size;
+
+    /* Reserve the pages for the file and the sentinel, then map the
+     * file over the start of them. The rest of the file's last page
+     * reads as 0, and so do any reserved pages past it.
+     */
+    maplen = mapSize(size);
+    p = mmap(NULL, maplen, PROT_READ, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (p == MAP_FAILED)
+        goto Lread;
+    if (mmap(p, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(p, maplen);
+        goto Lread;
+    }
+    // The whole file is about to be scanned
+    posix_madvise(p, size, POSIX_MADV_WILLNEED);
+
+    if (touchtime)
+        memcpy(touchtime, &buf, sizeof(buf));
+    close(fd);
+
+    if (!ref)
+        ::free(buffer);
+    ref = 2;
+    buffer = (unsigned char *)p;
+    len = size;
+    return 0;
+
+Lread:
+    close(fd);
     return read();
 #elif _WIN32
     HANDLE hFile;
     HANDLE hFileMap;
     DWORD size;
+    DWORD tail;
+    SYSTEM_INFO si;
     char *name;
 
     name = this->name->toChars();
@@ -235,6 +318,17 @@ int File::mmread()
     size = GetFileSize(hFile, NULL);
     //printf(" file created, size %d\n", size);
 
+    /* The view ends with the file's last page, so only if that has
+     * room for the sentinel can the view be used as is.
+     */
+    GetSystemInfo(&si);
+    tail = size % si.dwPageSize;
+    if (tail == 0 || tail > si.dwPageSize - 2)
+    {
+        CloseHandle(hFile);
+        return read();
+    }
+
     hFileMap = CreateFileMapping(hFile,NULL,PAGE_READONLY,0,size,NULL);
     if (CloseHandle(hFile) != TRUE)
         goto Lerr;
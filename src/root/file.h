@@ -24,7 +24,8 @@ struct FileName;
 
 struct File
 {
-    int ref;                    // != 0 if this is a reference to someone else's buffer
+    int ref;                    // != 0 if this is a reference to someone else's buffer,
+                                // 2 if it is a mapping made by mmread()
     unsigned char *buffer;      // data for our file
     size_t len;                 // amount of data in buffer[]
     void *touchtime;            // system time to use for file
@@ -43,11 +44,16 @@ struct File
 
     int read();
 
-    /* Read file, return !=0 if error
+    /* Read file by mapping it into memory, return !=0 if error
      */
 
     int mmread();
 
+    /* Release the buffer
+     */
+
+    void freeData();
+
     /* Write file, return !=0 if error
      */
 
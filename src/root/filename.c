@@ -16,6 +16,7 @@
 #include "array.h"
 #include "file.h"
 #include "rmem.h"
+#include "stringtable.h"
 
 #if defined (__sun)
 #include <alloca.h>
@@ -39,6 +40,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <utime.h>
+#include <dirent.h>
 #endif
 
 /****************************** FileName ********************************/
@@ -565,6 +567,155 @@ int FileName::exists(const char *name)
 #endif
 }
 
+/*************************************
+ * Same result as exists(), but answered from a listing of the
+ * directory name is in, read the first time that directory is
+ * looked in. Only use it for files that are not created or
+ * removed while the compiler runs, such as import files.
+ */
+
+enum DirEntryKind
+{
+    DEfile = 1,         // same values as exists() returns
+    DEdir = 2,
+    DEunknown,          // type not in listing, needs a stat()
+    DEnone,             // stat() found nothing, e.g. a dangling link
+};
+
+DirCacheStats FileName::dirCacheStats;
+
+struct DirListing
+{
+    StringTable entries;        // name => DirEntryKind
+    bool foldCase;              // the file system ignores case, so names are lower cased
+};
+
+static StringTable *dircache;  // directory name => DirListing
+
+/* Does the file system dir is on look up names case insensitively,
+ * so that stat() would find "Foo.d" when the directory has "foo.d"?
+ */
+static bool dirFoldsCase(const char *dir)
+{
+#if _WIN32
+    return true;
+#elif __APPLE__ && defined(_PC_CASE_SENSITIVE)
+    // The default file systems on OS X ignore case, but not all do
+    return pathconf(*dir ? dir : ".", _PC_CASE_SENSITIVE) == 0;
+#else
+    return false;
+#endif
+}
+
+static const char *dirEntryKey(DirListing *dl, const char *name, size_t len)
+{
+    if (!dl->foldCase)
+        return name;
+    char *key = (char *)mem.malloc(len + 1);
+    for (size_t i = 0; i < len; i++)
+        key[i] = tolower((unsigned char)name[i]);
+    key[len] = 0;
+    return key;
+}
+
+static void addDirEntry(DirListing *dl, const char *name, DirEntryKind kind)
+{
+    size_t len = strlen(name);
+    const char *key = dirEntryKey(dl, name, len);
+    StringValue *sv = dl->entries.update(key, len);
+    sv->ptrvalue = (void *)(size_t)kind;
+    if (key != name)
+        mem.free((void *)key);
+}
+
+/* Returns the entries of dir, which are none if it cannot be read.
+ */
+static DirListing *readDir(const char *dir)
+{
+    DirListing *dl = new DirListing();
+    dl->entries._init();
+    dl->foldCase = dirFoldsCase(dir);
+#if POSIX
+    DIR *d = opendir(*dir ? dir : ".");
+    if (d)
+    {
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL)
+        {
+            DirEntryKind kind = DEunknown;
+#ifdef DT_DIR
+            if (de->d_type == DT_REG)
+                kind = DEfile;
+            else if (de->d_type == DT_DIR)
+                kind = DEdir;
+#endif
+            addDirEntry(dl, de->d_name, kind);
+        }
+        closedir(d);
+    }
+#elif _WIN32
+    const char *pattern = FileName::combine(*dir ? dir : ".", "*");
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(pattern, &fd);
+    if (h != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            addDirEntry(dl, fd.cFileName,
+                (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? DEdir : DEfile);
+        } while (FindNextFileA(h, &fd));
+        FindClose(h);
+    }
+    FileName::free(pattern);
+#else
+    assert(0);
+#endif
+    FileName::dirCacheStats.dirs++;
+    return dl;
+}
+
+int FileName::existsCached(const char *name)
+{
+    dirCacheStats.lookups++;
+
+    const char *n = FileName::name(name);
+    if (!*n)
+    {
+        dirCacheStats.stats++;
+        return exists(name);
+    }
+
+    if (!dircache)
+    {
+        dircache = new StringTable();
+        dircache->_init();
+    }
+    const char *dir = FileName::path(name);
+    StringValue *sv = dircache->update(dir, strlen(dir));
+    if (!sv->ptrvalue)
+        sv->ptrvalue = readDir(dir);
+    FileName::free(dir);
+
+    DirListing *dl = (DirListing *)sv->ptrvalue;
+    size_t len = strlen(n);
+    const char *key = dirEntryKey(dl, n, len);
+    StringValue *se = dl->entries.lookup(key, len);
+    if (key != n)
+        mem.free((void *)key);
+    if (!se)
+        return 0;
+
+    DirEntryKind kind = (DirEntryKind)(size_t)se->ptrvalue;
+    if (kind == DEunknown)
+    {
+        dirCacheStats.stats++;
+        int result = exists(name);
+        kind = result ? (DirEntryKind)result : DEnone;
+        se->ptrvalue = (void *)(size_t)kind;
+    }
+    return kind == DEnone ? 0 : kind;
+}
+
 int FileName::ensurePathExists(const char *path)
 {
     //printf("FileName::ensurePathExists(%s)\n", path ? path : "");
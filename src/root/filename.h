@@ -21,6 +21,14 @@ class RootObject;
 template <typename TYPE> struct Array;
 typedef Array<const char *> Strings;
 
+// Counts kept by FileName::existsCached()
+struct DirCacheStats
+{
+    unsigned lookups;   // calls to existsCached()
+    unsigned dirs;      // directories listed
+    unsigned stats;     // lookups that still needed a stat()
+};
+
 struct FileName
 {
     const char *str;
@@ -49,6 +57,8 @@ struct FileName
     static const char *searchPath(Strings *path, const char *name, int cwd);
     static const char *safeSearchPath(Strings *path, const char *name);
     static int exists(const char *name);
+    static int existsCached(const char *name);
+    static DirCacheStats dirCacheStats;
     static int ensurePathExists(const char *path);
     static const char *canonicalName(const char *name);
 
@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "rmem.h"
+#include "thread.h"
 
 /* This implementation of the storage allocator uses the standard C allocation package.
  */
@@ -116,9 +117,33 @@ void Mem::error()
 
 /* =================================================== */
 
+// Each thread counts its own allocations
+static THREAD_LOCAL size_t livebytes[MEMmax];
+static THREAD_LOCAL size_t liveobjects[MEMmax];
+
+void Mem::takeStats(MemStats *stats)
+{
+    for (int i = 0; i < MEMmax; i++)
+    {
+        stats->bytes[i] = livebytes[i];
+        stats->objects[i] = liveobjects[i];
+        livebytes[i] = 0;
+        liveobjects[i] = 0;
+    }
+}
+
+void Mem::addStats(MemStats *stats)
+{
+    for (int i = 0; i < MEMmax; i++)
+    {
+        livebytes[i] += stats->bytes[i];
+        liveobjects[i] += stats->objects[i];
+    }
+}
+
 #if 1
 
-/* Allocate, but never release
+/* Allocate from arenas, which are only given back by release()
  */
 
 // Allocate a little less than 64kB because the C runtime adds some overhead that
@@ -127,42 +152,83 @@ void Mem::error()
 // than 64kB, so it cannot be used by another chunk.
 #define CHUNK_SIZE (4096 * 16 - 64)
 
-static size_t heapleft = 0;
-static void *heapp;
+// Each thread allocates from its own chunk per kind, so no locking is needed
+static THREAD_LOCAL size_t heapleft[MEMmax];
+static THREAD_LOCAL char *heapp[MEMmax];
 
-void * operator new(size_t m_size)
+/* The chunks of each kind, newest first, so that release() can find
+ * those allocated since a mark. Allocations too big for a chunk get
+ * one of their own.
+ */
+struct Chunk
+{
+    Chunk *prev;
+};
+#define CHUNK_HEADER ((sizeof(Chunk) + 15) & ~15)
+
+static THREAD_LOCAL Chunk *chunks[MEMmax];
+
+static char *newChunk(MemKind kind, size_t size)
+{
+    Chunk *c = (Chunk *)::malloc(CHUNK_HEADER + size);
+    if (!c)
+        mem.error();
+    c->prev = chunks[kind];
+    chunks[kind] = c;
+    return (char *)c + CHUNK_HEADER;
+}
+
+void *Mem::allocate(MemKind kind, size_t m_size)
 {
     // 16 byte alignment is better (and sometimes needed) for doubles
     m_size = (m_size + 15) & ~15;
+    livebytes[kind] += m_size;
+    liveobjects[kind]++;
 
     // The layout of the code is selected so the most common case is straight through
-    if (m_size <= heapleft)
+    if (m_size <= heapleft[kind])
     {
      L1:
-        heapleft -= m_size;
-        void *p = heapp;
-        heapp = (void *)((char *)heapp + m_size);
+        heapleft[kind] -= m_size;
+        void *p = heapp[kind];
+        heapp[kind] += m_size;
         return p;
     }
 
-    if (m_size > CHUNK_SIZE)
-    {
-        void *p = malloc(m_size);
-        if (p)
-            return p;
-        printf("Error: out of memory\n");
-        exit(EXIT_FAILURE);
-        return p;
-    }
+    if (m_size > CHUNK_SIZE - CHUNK_HEADER)
+        return newChunk(kind, m_size);
+
+    heapleft[kind] = CHUNK_SIZE - CHUNK_HEADER;
+    heapp[kind] = newChunk(kind, CHUNK_SIZE - CHUNK_HEADER);
+    goto L1;
+}
 
-    heapleft = CHUNK_SIZE;
-    heapp = malloc(CHUNK_SIZE);
-    if (!heapp)
+void Mem::mark(MemKind kind, MemMark *m)
+{
+    m->chunk = chunks[kind];
+    m->p = heapp[kind];
+    m->left = heapleft[kind];
+    m->bytes = livebytes[kind];
+    m->objects = liveobjects[kind];
+}
+
+void Mem::release(MemKind kind, MemMark *m)
+{
+    while (chunks[kind] != m->chunk)
     {
-        printf("Error: out of memory\n");
-        exit(EXIT_FAILURE);
+        Chunk *c = chunks[kind];
+        chunks[kind] = c->prev;
+        ::free(c);
     }
-    goto L1;
+    heapp[kind] = m->p;
+    heapleft[kind] = m->left;
+    livebytes[kind] = m->bytes;
+    liveobjects[kind] = m->objects;
+}
+
+void * operator new(size_t m_size)
+{
+    return mem.allocate(MEMother, m_size);
 }
 
 void operator delete(void *p)
@@ -171,6 +237,24 @@ void operator delete(void *p)
 
 #else
 
+void *Mem::allocate(MemKind kind, size_t m_size)
+{
+    livebytes[kind] += (m_size + 15) & ~15;
+    liveobjects[kind]++;
+    return malloc(m_size);
+}
+
+// Allocations aren't tracked, so release() leaves them be
+void Mem::mark(MemKind kind, MemMark *m)
+{
+    m->bytes = livebytes[kind];
+    m->objects = liveobjects[kind];
+}
+
+void Mem::release(MemKind kind, MemMark *m)
+{
+}
+
 void * operator new(size_t m_size)
 {
     void *p = malloc(m_size);
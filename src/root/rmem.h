@@ -12,6 +12,38 @@
 
 #include <stddef.h>     // for size_t
 
+/* What an allocation is for. Each kind gets its own arena,
+ * and live bytes and objects are counted per kind.
+ */
+enum MemKind
+{
+    MEMother,
+    MEMtoken,
+    MEMexpression,
+    MEMtype,
+    MEMdsymbol,
+    MEMtemplateinstance,
+    MEMctfe,
+    MEMmax
+};
+
+struct MemStats
+{
+    size_t bytes[MEMmax];
+    size_t objects[MEMmax];
+};
+
+/* How far the allocations of one kind had got, see Mem::mark()
+ */
+struct MemMark
+{
+    void *chunk;        // newest chunk
+    char *p;            // where the next allocation would go
+    size_t left;
+    size_t bytes;
+    size_t objects;
+};
+
 struct Mem
 {
     Mem() { }
@@ -23,6 +55,21 @@ struct Mem
     void free(void *p);
     void *mallocdup(void *o, size_t size);
     void error();
+
+    // Allocate from the arena for kind, never released unless by release()
+    void *allocate(MemKind kind, size_t size);
+
+    /* Free everything allocated for kind since mark() was called on the
+     * same thread, all at once. Marks must be released in reverse order.
+     */
+    void mark(MemKind kind, MemMark *m);
+    void release(MemKind kind, MemMark *m);
+
+    /* The counts are kept per thread. takeStats() moves the calling
+     * thread's counts into stats, addStats() adds them back to it.
+     */
+    void takeStats(MemStats *stats);
+    void addStats(MemStats *stats);
 };
 
 extern Mem mem;
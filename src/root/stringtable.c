@@ -17,42 +17,66 @@
 #include "rmem.h"                       // mem
 #include "stringtable.h"
 
+#define PRIME1  0x9E3779B185EBCA87ULL
+#define PRIME2  0xC2B2AE3D27D4EB4FULL
+#define PRIME3  0x165667B19E3779F9ULL
+#define PRIME4  0x85EBCA77C2B2AE63ULL
+#define PRIME5  0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, n)    (((x) << (n)) | ((x) >> (64 - (n))))
+
+static inline uint64_t load64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));          // no alignment requirement
+    return v;
+}
+
+static inline uint64_t load32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**************************************
+ * Hash in the manner of the short input path of xxHash64:
+ * 8 bytes at a time, then the 4 and 1 byte tails, then a final
+ * avalanche so every input bit affects the low bits the table uses.
+ */
+
 // TODO: Merge with root.String
 hash_t calcHash(const char *str, size_t len)
 {
-    hash_t hash = 0;
+    const uint8_t *p = (const uint8_t *)str;
+    uint64_t h = PRIME5 + len;
 
-    while (1)
+    for (; len >= 8; p += 8, len -= 8)
+    {
+        uint64_t k = load64(p) * PRIME2;
+        k = ROTL64(k, 31) * PRIME1;
+        h ^= k;
+        h = ROTL64(h, 27) * PRIME1 + PRIME4;
+    }
+    if (len >= 4)
     {
-        switch (len)
-        {
-            case 0:
-                return hash;
-
-            case 1:
-                hash *= 37;
-                hash += *(const uint8_t *)str;
-                return hash;
-
-            case 2:
-                hash *= 37;
-                hash += *(const uint16_t *)str;
-                return hash;
-
-            case 3:
-                hash *= 37;
-                hash += (*(const uint16_t *)str << 8) +
-                        ((const uint8_t *)str)[2];
-                return hash;
-
-            default:
-                hash *= 37;
-                hash += *(const uint32_t *)str;
-                str += 4;
-                len -= 4;
-                break;
-        }
+        h ^= load32(p) * PRIME1;
+        h = ROTL64(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+        len -= 4;
     }
+    for (; len; p++, len--)
+    {
+        h ^= *p * PRIME5;
+        h = ROTL64(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return (hash_t)h;
 }
 
 void StringValue::ctor(const char *p, size_t length)
@@ -62,115 +86,153 @@ void StringValue::ctor(const char *p, size_t length)
     memcpy(this->lstring, p, length * sizeof(char));
 }
 
+struct StringEntry
+{
+    StringValue value;
+
+    static size_t size(size_t len) { return sizeof(StringEntry) + len + 1; }
+    void ctor(const char *s, size_t len);
+};
+
+void StringEntry::ctor(const char *s, size_t len)
+{
+    value.ptrvalue = NULL;
+    value.ctor(s, len);
+}
+
+struct StringSlot
+{
+    hash_t hash;
+    StringEntry *entry;         // NULL if slot is empty
+};
+
+// Entries are carved out of chunks of this size
+#define CHUNK_SIZE (4096 * 16 - 64)
+
 void StringTable::_init(size_t size)
 {
-    table = (void **)mem.calloc(size, sizeof(void *));
-    tabledim = size;
+    tabledim = 16;
+    while (tabledim < size)
+        tabledim <<= 1;
+    table = (StringSlot *)mem.calloc(tabledim, sizeof(StringSlot));
     count = 0;
+    chunks = NULL;
+    pool = NULL;
+    poolleft = 0;
 }
 
 StringTable::~StringTable()
 {
-    // Zero out dangling pointers to help garbage collector.
-    // Should zero out StringEntry's too.
-    for (size_t i = 0; i < count; i++)
-        table[i] = NULL;
+    while (chunks)
+    {
+        void *next = *(void **)chunks;
+        mem.free(chunks);
+        chunks = next;
+    }
+    pool = NULL;
+    poolleft = 0;
 
     mem.free(table);
     table = NULL;
+    count = 0;
 }
 
-struct StringEntry
+void *StringTable::alloc(size_t size)
 {
-    StringEntry *left;
-    StringEntry *right;
-    hash_t hash;
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    if (size > poolleft)
+    {
+        size_t chunksize = sizeof(void *) + size;
+        if (chunksize < CHUNK_SIZE)
+            chunksize = CHUNK_SIZE;
+        void **chunk = (void **)mem.malloc(chunksize);
+        *chunk = chunks;
+        chunks = chunk;
+        pool = (char *)(chunk + 1);
+        poolleft = chunksize - sizeof(void *);
+    }
+    void *p = pool;
+    pool += size;
+    poolleft -= size;
+    return p;
+}
 
-    StringValue value;
+/**************************************
+ * Find the slot for s, which is either the one holding it
+ * or the empty one where it would go.
+ */
 
-    static StringEntry *alloc(const char *s, size_t len);
-};
+StringSlot *StringTable::search(const char *s, size_t len, hash_t hash)
+{
+    //printf("StringTable::search(%p,%d)\n",s,len);
+    size_t mask = tabledim - 1;
+    size_t i = hash & mask;
+    while (1)
+    {
+        StringSlot *slot = &table[i];
+        if (!slot->entry)
+            return slot;
+        if (slot->hash == hash &&
+            slot->entry->value.len() == len &&
+            ::memcmp(s, slot->entry->value.toDchars(), len) == 0)
+            return slot;
+        i = (i + 1) & mask;
+    }
+}
 
-StringEntry *StringEntry::alloc(const char *s, size_t len)
+StringValue *StringTable::add(StringSlot *slot, const char *s, size_t len, hash_t hash)
 {
-    StringEntry *se;
+    StringEntry *se = (StringEntry *)alloc(StringEntry::size(len));
+    se->ctor(s, len);
+    slot->hash = hash;
+    slot->entry = se;
 
-    se = (StringEntry *) mem.calloc(1,sizeof(StringEntry) + len + 1);
-    se->value.ctor(s, len);
-    se->hash = calcHash(s,len);
-    return se;
+    if (++count * 2 > tabledim)
+        grow();
+    return &se->value;
 }
 
-void **StringTable::search(const char *s, size_t len)
+void StringTable::grow()
 {
-    hash_t hash;
-    unsigned u;
-    int cmp;
-    StringEntry **se;
+    size_t olddim = tabledim;
+    StringSlot *oldtable = table;
 
-    //printf("StringTable::search(%p,%d)\n",s,len);
-    hash = calcHash(s,len);
-    u = hash % tabledim;
-    se = (StringEntry **)&table[u];
-    //printf("\thash = %d, u = %d\n",hash,u);
-    while (*se)
+    tabledim = olddim * 2;
+    table = (StringSlot *)mem.calloc(tabledim, sizeof(StringSlot));
+    size_t mask = tabledim - 1;
+    for (size_t u = 0; u < olddim; u++)
     {
-        cmp = (*se)->hash - hash;
-        if (cmp == 0)
-        {
-            cmp = (*se)->value.len() - len;
-            if (cmp == 0)
-            {
-                cmp = ::memcmp(s,(*se)->value.toDchars(),len);
-                if (cmp == 0)
-                    break;
-            }
-        }
-        if (cmp < 0)
-            se = &(*se)->left;
-        else
-            se = &(*se)->right;
+        StringSlot *old = &oldtable[u];
+        if (!old->entry)
+            continue;
+        size_t i = old->hash & mask;
+        while (table[i].entry)
+            i = (i + 1) & mask;
+        table[i] = *old;
     }
-    //printf("\treturn %p, %p\n",se, (*se));
-    return (void **)se;
+    mem.free(oldtable);
 }
 
 StringValue *StringTable::lookup(const char *s, size_t len)
-{   StringEntry *se;
-
-    se = *(StringEntry **)search(s,len);
-    if (se)
-        return &se->value;
-    else
-        return NULL;
+{
+    StringSlot *slot = search(s, len, calcHash(s, len));
+    return slot->entry ? &slot->entry->value : NULL;
 }
 
 StringValue *StringTable::update(const char *s, size_t len)
-{   StringEntry **pse;
-    StringEntry *se;
-
-    pse = (StringEntry **)search(s,len);
-    se = *pse;
-    if (!se)                    // not in table: so create new entry
-    {
-        se = StringEntry::alloc(s, len);
-        *pse = se;
-    }
-    return &se->value;
+{
+    hash_t hash = calcHash(s, len);
+    StringSlot *slot = search(s, len, hash);
+    if (slot->entry)
+        return &slot->entry->value;
+    return add(slot, s, len, hash);     // not in table: so create new entry
 }
 
 StringValue *StringTable::insert(const char *s, size_t len)
-{   StringEntry **pse;
-    StringEntry *se;
-
-    pse = (StringEntry **)search(s,len);
-    se = *pse;
-    if (se)
+{
+    hash_t hash = calcHash(s, len);
+    StringSlot *slot = search(s, len, hash);
+    if (slot->entry)
         return NULL;            // error: already in table
-    else
-    {
-        se = StringEntry::alloc(s, len);
-        *pse = se;
-    }
-    return &se->value;
+    return add(slot, s, len, hash);
 }
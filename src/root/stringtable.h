@@ -45,12 +45,23 @@ private:
     void ctor(const char *p, size_t length);
 };
 
+struct StringSlot;
+
+/* Open addressed hash table of strings, with linear probing.
+ * The table doubles when it gets half full. The StringValues live in
+ * chunks owned by the table, so they never move and stay valid until
+ * the table is destroyed.
+ */
 struct StringTable
 {
 private:
-    void **table;
+    StringSlot *table;
     size_t count;
-    size_t tabledim;
+    size_t tabledim;            // always a power of 2
+
+    void *chunks;               // list of chunks the entries are allocated from
+    char *pool;
+    size_t poolleft;
 
 public:
     void _init(size_t size = 37);
@@ -61,7 +72,10 @@ public:
     StringValue *update(const char *s, size_t len);
 
 private:
-    void **search(const char *s, size_t len);
+    StringSlot *search(const char *s, size_t len, hash_t hash);
+    StringValue *add(StringSlot *slot, const char *s, size_t len, hash_t hash);
+    void grow();
+    void *alloc(size_t size);
 };
 
 #endif
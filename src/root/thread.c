@@ -0,0 +1,257 @@
+
+// Copyright (c) 2014 by Digital Mars
+// All Rights Reserved
+// http://www.digitalmars.com
+// License for redistribution is by either the Artistic License
+// in artistic.txt, or the GNU General Public License in gnu.txt.
+// See the included readme.txt for details.
+
+#define _MT 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "thread.h"
+
+#if _WIN32
+
+#include <windows.h>
+#include <process.h>
+
+ThreadId Thread::getId()
+{
+    return (ThreadId)GetCurrentThreadId();
+}
+
+unsigned Thread::numProcessors()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? si.dwNumberOfProcessors : 1;
+}
+
+Mutex *Mutex::create()
+{
+    CRITICAL_SECTION *cs = (CRITICAL_SECTION *)malloc(sizeof(CRITICAL_SECTION));
+    assert(cs);
+    InitializeCriticalSection(cs);
+    return (Mutex *)cs;
+}
+
+void Mutex::lock()
+{
+    EnterCriticalSection((CRITICAL_SECTION *)this);
+}
+
+void Mutex::unlock()
+{
+    LeaveCriticalSection((CRITICAL_SECTION *)this);
+}
+
+void Mutex::dispose(Mutex *m)
+{
+    DeleteCriticalSection((CRITICAL_SECTION *)m);
+    free(m);
+}
+
+struct PoolData
+{
+    WorkPool::Job job;
+    void *ctx;
+    size_t njobs;
+    volatile LONG next;
+};
+
+static void work(PoolData *pd)
+{
+    while (1)
+    {
+        size_t i = (size_t)InterlockedIncrement(&pd->next) - 1;
+        if (i >= pd->njobs)
+            break;
+        pd->job(pd->ctx, i);
+    }
+}
+
+static unsigned __stdcall poolthread(void *p)
+{
+    work((PoolData *)p);
+    _endthreadex(EXIT_SUCCESS);
+    return EXIT_SUCCESS;                // if skidding
+}
+
+void WorkPool::run(size_t njobs, unsigned nthreads, Job job, void *ctx)
+{
+    PoolData pd;
+    pd.job = job;
+    pd.ctx = ctx;
+    pd.njobs = njobs;
+    pd.next = 0;
+
+    if (nthreads > njobs)
+        nthreads = (unsigned)njobs;
+    HANDLE *threads = NULL;
+    unsigned nstarted = 0;
+    if (nthreads > 1)
+    {
+        threads = (HANDLE *)malloc((nthreads - 1) * sizeof(HANDLE));
+        assert(threads);
+        for (; nstarted < nthreads - 1; nstarted++)
+        {
+            unsigned threadaddr;
+            HANDLE h = (HANDLE) _beginthreadex(NULL, 0, &poolthread, &pd, 0, &threadaddr);
+            if (!h)
+                break;          // make do with fewer threads
+            threads[nstarted] = h;
+        }
+    }
+    work(&pd);
+    for (unsigned i = 0; i < nstarted; i++)
+    {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+    free(threads);
+}
+
+#elif __linux__ || __APPLE__ || __FreeBSD__ || __OpenBSD__ || __sun  // Posix
+
+#include <pthread.h>
+#include <unistd.h>
+
+ThreadId Thread::getId()
+{
+    return (ThreadId)pthread_self();
+}
+
+unsigned Thread::numProcessors()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1;
+}
+
+Mutex *Mutex::create()
+{
+    pthread_mutex_t *m = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    assert(m);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    int status = pthread_mutex_init(m, &attr);
+    assert(status == 0);
+    pthread_mutexattr_destroy(&attr);
+    return (Mutex *)m;
+}
+
+void Mutex::lock()
+{
+    pthread_mutex_lock((pthread_mutex_t *)this);
+}
+
+void Mutex::unlock()
+{
+    pthread_mutex_unlock((pthread_mutex_t *)this);
+}
+
+void Mutex::dispose(Mutex *m)
+{
+    pthread_mutex_destroy((pthread_mutex_t *)m);
+    free(m);
+}
+
+struct PoolData
+{
+    WorkPool::Job job;
+    void *ctx;
+    size_t njobs;
+    size_t next;
+    pthread_mutex_t mutex;
+};
+
+static void work(PoolData *pd)
+{
+    while (1)
+    {
+        pthread_mutex_lock(&pd->mutex);
+        size_t i = pd->next++;
+        pthread_mutex_unlock(&pd->mutex);
+        if (i >= pd->njobs)
+            break;
+        pd->job(pd->ctx, i);
+    }
+}
+
+static void *poolthread(void *p)
+{
+    work((PoolData *)p);
+    return NULL;                        // end thread
+}
+
+void WorkPool::run(size_t njobs, unsigned nthreads, Job job, void *ctx)
+{
+    PoolData pd;
+    pd.job = job;
+    pd.ctx = ctx;
+    pd.njobs = njobs;
+    pd.next = 0;
+    pthread_mutex_init(&pd.mutex, NULL);
+
+    if (nthreads > njobs)
+        nthreads = (unsigned)njobs;
+    pthread_t *threads = NULL;
+    unsigned nstarted = 0;
+    if (nthreads > 1)
+    {
+        threads = (pthread_t *)malloc((nthreads - 1) * sizeof(pthread_t));
+        assert(threads);
+        for (; nstarted < nthreads - 1; nstarted++)
+        {
+            if (pthread_create(&threads[nstarted], NULL, &poolthread, &pd) != 0)
+                break;          // make do with fewer threads
+        }
+    }
+    work(&pd);
+    for (unsigned i = 0; i < nstarted; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+    pthread_mutex_destroy(&pd.mutex);
+}
+
+#else
+
+ThreadId Thread::getId()
+{
+    return 0;
+}
+
+unsigned Thread::numProcessors()
+{
+    return 1;
+}
+
+Mutex *Mutex::create()
+{
+    return (Mutex *)malloc(1);
+}
+
+void Mutex::lock()
+{
+}
+
+void Mutex::unlock()
+{
+}
+
+void Mutex::dispose(Mutex *m)
+{
+    free(m);
+}
+
+void WorkPool::run(size_t njobs, unsigned nthreads, Job job, void *ctx)
+{
+    for (size_t i = 0; i < njobs; i++)
+        job(ctx, i);
+}
+
+#endif
@@ -1,12 +1,64 @@
 
+// Copyright (c) 2014 by Digital Mars
+// All Rights Reserved
+// http://www.digitalmars.com
+// License for redistribution is by either the Artistic License
+// in artistic.txt, or the GNU General Public License in gnu.txt.
+// See the included readme.txt for details.
+
 #ifndef THREAD_H
 #define THREAD_H 1
 
+#if __DMC__
+#pragma once
+#endif
+
+#include <stddef.h>
+
+/* Storage class for data that each thread gets its own copy of.
+ * Only usable for plain data with constant initializers.
+ */
+#if _MSC_VER || __DMC__
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 typedef long ThreadId;
 
 struct Thread
 {
     static ThreadId getId();
+
+    /* Number of processors available, never less than 1.
+     */
+    static unsigned numProcessors();
+};
+
+/*******************
+ * Recursive mutual exclusion lock.
+ */
+
+struct Mutex
+{
+    static Mutex *create();
+    void lock();
+    void unlock();
+    static void dispose(Mutex *);
+};
+
+/*******************
+ * Run job(ctx, i) for every i in [0 .. njobs) on up to nthreads
+ * threads, the calling thread being one of them.
+ * Returns when all jobs are done.
+ * Jobs are handed out in increasing order of i.
+ */
+
+struct WorkPool
+{
+    typedef void (*Job)(void *ctx, size_t i);
+
+    static void run(size_t njobs, unsigned nthreads, Job job, void *ctx);
 };
 
 #endif
@@ -0,0 +1,171 @@
+
+// Copyright (c) 2014 by Digital Mars
+// All Rights Reserved
+// http://www.digitalmars.com
+// License for redistribution is by either the Artistic License
+// in artistic.txt, or the GNU General Public License in gnu.txt.
+// See the included readme.txt for details.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include "port.h"
+#include "rmem.h"
+#include "object.h"
+#include "outbuffer.h"
+#include "thread.h"
+#include "timetrace.h"
+
+struct TraceEvent
+{
+    const char *name;
+    char *detail;               // NULL if none
+    ulonglong ts;               // start, in microseconds since TimeTrace::start()
+    ulonglong dur;              // duration in microseconds
+    unsigned tid;
+};
+
+bool TimeTrace::enabled = false;
+
+static unsigned granularity;
+static ulonglong epoch;
+static Mutex *eventsLock;
+static TraceEvent *events;
+static size_t eventsdim;
+static size_t eventsallocdim;
+static unsigned nthreads;
+
+// Start times of the events each thread has begun but not ended
+static THREAD_LOCAL ulonglong *stack;
+static THREAD_LOCAL size_t stackdepth;
+static THREAD_LOCAL size_t stackdim;
+static THREAD_LOCAL unsigned tid;      // 0 means not assigned yet
+
+/********************************
+ * Microseconds from some fixed point.
+ */
+
+ulonglong TimeTrace::now()
+{
+#if _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    // Split to avoid overflowing count * 1000000
+    return (count.QuadPart / freq.QuadPart) * 1000000 +
+           (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (ulonglong)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+void TimeTrace::start(unsigned granularity)
+{
+    ::granularity = granularity;
+    epoch = now();
+    eventsLock = Mutex::create();
+    tid = ++nthreads;           // the main thread
+    enabled = true;
+}
+
+void TimeTrace::push()
+{
+    if (stackdepth == stackdim)
+    {
+        stackdim = stackdim ? stackdim * 2 : 64;
+        stack = (ulonglong *)mem.realloc(stack, stackdim * sizeof(ulonglong));
+    }
+    stack[stackdepth++] = now();
+}
+
+void TimeTrace::pop(const char *name, const char *detail, RootObject *o)
+{
+    assert(stackdepth);
+    ulonglong start = stack[--stackdepth];
+    ulonglong dur = now() - start;
+    if (dur < granularity)
+        return;
+
+    if (o)
+        detail = o->toChars();
+
+    eventsLock->lock();
+    if (!tid)
+        tid = ++nthreads;
+    if (eventsdim == eventsallocdim)
+    {
+        eventsallocdim = eventsallocdim ? eventsallocdim * 2 : 1024;
+        events = (TraceEvent *)mem.realloc(events, eventsallocdim * sizeof(TraceEvent));
+    }
+    TraceEvent *te = &events[eventsdim++];
+    te->name = name;
+    te->detail = detail ? mem.strdup(detail) : NULL;
+    te->ts = start - epoch;
+    te->dur = dur;
+    te->tid = tid;
+    eventsLock->unlock();
+}
+
+static void writeString(OutBuffer *buf, const char *s)
+{
+    buf->writeByte('"');
+    for (; *s; s++)
+    {
+        unsigned char c = *s;
+        switch (c)
+        {
+            case '"':   buf->writestring("\\\"");   break;
+            case '\\':  buf->writestring("\\\\");   break;
+            case '\n':  buf->writestring("\\n");    break;
+            case '\t':  buf->writestring("\\t");    break;
+            default:
+                if (c < ' ')
+                    buf->printf("\\u%04x", c);
+                else
+                    buf->writeByte(c);
+                break;
+        }
+    }
+    buf->writeByte('"');
+}
+
+/********************************
+ * Write the events recorded so far as a Chrome trace event file.
+ */
+
+void TimeTrace::write(OutBuffer *buf)
+{
+    buf->writestring("{\"traceEvents\":[\n");
+    for (size_t i = 0; i < eventsdim; i++)
+    {
+        TraceEvent *te = &events[i];
+        buf->printf("{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu,\"name\":",
+            te->tid, te->ts, te->dur);
+        writeString(buf, te->name);
+        if (te->detail)
+        {
+            buf->writestring(",\"args\":{\"detail\":");
+            writeString(buf, te->detail);
+            buf->writeByte('}');
+        }
+        buf->writestring("},\n");
+    }
+    // Name the threads, which also avoids a trailing comma
+    for (unsigned t = 1; t <= nthreads; t++)
+    {
+        buf->printf("{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", t);
+        writeString(buf, t == 1 ? "main" : "worker");
+        buf->printf("}}%s\n", t == nthreads ? "" : ",");
+    }
+    buf->writestring("],\n\"displayTimeUnit\":\"ms\"}\n");
+}
@@ -0,0 +1,85 @@
+
+// Copyright (c) 2014 by Digital Mars
+// All Rights Reserved
+// http://www.digitalmars.com
+// License for redistribution is by either the Artistic License
+// in artistic.txt, or the GNU General Public License in gnu.txt.
+// See the included readme.txt for details.
+
+#ifndef TIMETRACE_H
+#define TIMETRACE_H 1
+
+#if __DMC__
+#pragma once
+#endif
+
+#include <stddef.h>
+
+class RootObject;
+struct OutBuffer;
+
+/*******************
+ * Records how long named pieces of work take, as nested begin/end
+ * pairs, and writes them out in the Chrome trace event format
+ * (load the file in chrome://tracing or a compatible viewer).
+ * Recording is off until start() is called; until then a
+ * begin/end pair costs only two tests of enabled.
+ */
+
+struct TimeTrace
+{
+    static bool enabled;
+
+    /* Start recording. Events shorter than granularity
+     * microseconds are dropped.
+     */
+    static void start(unsigned granularity);
+
+    static void begin() { if (enabled) push(); }
+    static void end(const char *name, const char *detail = NULL) { if (enabled) pop(name, detail, NULL); }
+    static void end(const char *name, RootObject *o) { if (enabled) pop(name, NULL, o); }
+
+    static void write(OutBuffer *buf);
+
+    // Microseconds from some fixed point
+    static unsigned long long now();
+
+private:
+    static void push();
+    static void pop(const char *name, const char *detail, RootObject *o);
+};
+
+/*******************
+ * Record the lifetime of the scope as one event.
+ * The detail object, if any, is converted to a string only
+ * if the event is kept.
+ */
+
+struct TimeTraceScope
+{
+    const char *name;
+    const char *detail;
+    RootObject *o;
+
+    TimeTraceScope(const char *name, const char *detail = NULL)
+        : name(name), detail(detail), o(NULL)
+    {
+        TimeTrace::begin();
+    }
+
+    TimeTraceScope(const char *name, RootObject *o)
+        : name(name), detail(NULL), o(o)
+    {
+        TimeTrace::begin();
+    }
+
+    ~TimeTraceScope()
+    {
+        if (o)
+            TimeTrace::end(name, o);
+        else
+            TimeTrace::end(name, detail);
+    }
+};
+
+#endif
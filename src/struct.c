@@ -21,6 +21,8 @@
 #include "id.h"
 #include "statement.h"
 #include "template.h"
+#include "expression.h"
+#include "ctfe.h"
 
 FuncDeclaration *StructDeclaration::xerreq;     // object.xopEquals
 FuncDeclaration *StructDeclaration::xerrcmp;    // object.xopCmp
@@ -252,6 +254,8 @@ unsigned AggregateDeclaration::size(Loc loc)
     //printf("AggregateDeclaration::size() %s, scope = %p\n", toChars(), scope);
     if (loc.linnum == 0)
         loc = this->loc;
+    // Finishing semantic analysis may be needed, which CTFE must not free
+    CtfeRegionSuspend crs;
     if (sizeok != SIZEOKdone && scope)
         semantic(NULL);
 
@@ -17,6 +17,7 @@
 #include "aav.h"
 #include "rmem.h"
 #include "stringtable.h"
+#include "timetrace.h"
 
 #include "mtype.h"
 #include "template.h"
@@ -5102,6 +5103,11 @@ RootObject *TemplateTupleParameter::defaultArg(Loc loc, Scope *sc)
 
 /* ======================== TemplateInstance ================================ */
 
+void *TemplateInstance::operator new(size_t size)
+{
+    return mem.allocate(MEMtemplateinstance, size);
+}
+
 TemplateInstance::TemplateInstance(Loc loc, Identifier *ident)
     : ScopeDsymbol(NULL)
 {
@@ -5256,6 +5262,7 @@ void TemplateInstance::trySemantic3(Scope *sc2)
 
 void TemplateInstance::semantic(Scope *sc, Expressions *fargs)
 {
+    TimeTraceScope tts("Template instance", this);
     //printf("TemplateInstance::semantic('%s', this=%p, gag = %d, sc = %p)\n", toChars(), this, global.gag, sc);
 #if 0
     for (Dsymbol *s = this; s; s = s->parent)
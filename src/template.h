@@ -321,6 +321,7 @@ public:
     TemplateInstances* deferred;
 
     TemplateInstance(Loc loc, Identifier *temp_id);
+    static void *operator new(size_t sz);
     TemplateInstance(Loc loc, TemplateDeclaration *tempdecl, Objects *tiargs);
     static Objects *arraySyntaxCopy(Objects *objs);
     Dsymbol *syntaxCopy(Dsymbol *);
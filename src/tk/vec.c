@@ -10,6 +10,17 @@
 #include        "vec.h"
 #include        "mem.h"
 
+#if __SSE2__ && __GNUC__
+/* Do the dense operations 16 bytes at a time.
+ */
+#define VEC_SIMD        1
+#include        <emmintrin.h>
+
+#define SIMDDIM         (sizeof(__m128i) / sizeof(vec_base_t))  // words per 16 bytes
+#define SIMDLOAD(p)     _mm_loadu_si128((const __m128i *)(p))
+#define SIMDSTORE(p,x)  _mm_storeu_si128((__m128i *)(p),(x))
+#endif
+
 static int vec_count;           /* # of vectors allocated               */
 static int vec_initcount = 0;   /* # of times package is initialized    */
 
@@ -359,15 +370,33 @@ size_t vec_index(size_t b,vec_t vec)
         starv = *v >> bit;
         while (1)
         {
+#if __GNUC__
+                if (starv)
+                {       if (sizeof(starv) == sizeof(long))
+                                return b + __builtin_ctzl(starv);
+                        return b + __builtin_ctzll(starv);
+                }
+#else
                 while (starv)
                 {       if (starv & 1)
                                 return b;
                         b++;
                         starv >>= 1;
                 }
+#endif
                 b = (b + VECBITS) & ~VECMASK;   /* round up to next word */
                 if (++v >= vtop)
                     break;
+#if VEC_SIMD
+                // Skip runs of empty words, common in large sparse vectors
+                while (v + SIMDDIM <= vtop &&
+                       _mm_movemask_epi8(_mm_cmpeq_epi8(SIMDLOAD(v),_mm_setzero_si128())) == 0xFFFF)
+                {       v += SIMDDIM;
+                        b += SIMDDIM * VECBITS;
+                }
+                if (v >= vtop)
+                    break;
+#endif
                 starv = *v;
         }
     }
@@ -386,6 +415,10 @@ void vec_andass(vec_t v1,vec_t v2)
         assert(v2);
         assert(vec_numbits(v1)==vec_numbits(v2));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM)
+            SIMDSTORE(v1,_mm_and_si128(SIMDLOAD(v1),SIMDLOAD(v2)));
+#endif
         for (; v1 < vtop; v1++,v2++)
             *v1 &= *v2;
     }
@@ -405,6 +438,10 @@ void vec_and(vec_t v1,vec_t v2,vec_t v3)
         assert(v2 && v3);
         assert(vec_numbits(v1)==vec_numbits(v2) && vec_numbits(v1)==vec_numbits(v3));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM,v3 += SIMDDIM)
+            SIMDSTORE(v1,_mm_and_si128(SIMDLOAD(v2),SIMDLOAD(v3)));
+#endif
         for (; v1 < vtop; v1++,v2++,v3++)
             *v1 = *v2 & *v3;
     }
@@ -424,6 +461,10 @@ void vec_xorass(vec_t v1,vec_t v2)
         assert(v2);
         assert(vec_numbits(v1)==vec_numbits(v2));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM)
+            SIMDSTORE(v1,_mm_xor_si128(SIMDLOAD(v1),SIMDLOAD(v2)));
+#endif
         for (; v1 < vtop; v1++,v2++)
             *v1 ^= *v2;
     }
@@ -443,6 +484,10 @@ void vec_xor(vec_t v1,vec_t v2,vec_t v3)
         assert(v2 && v3);
         assert(vec_numbits(v1)==vec_numbits(v2) && vec_numbits(v1)==vec_numbits(v3));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM,v3 += SIMDDIM)
+            SIMDSTORE(v1,_mm_xor_si128(SIMDLOAD(v2),SIMDLOAD(v3)));
+#endif
         for (; v1 < vtop; v1++,v2++,v3++)
             *v1 = *v2 ^ *v3;
     }
@@ -485,6 +530,10 @@ void vec_orass(vec_t v1,vec_t v2)
         #endif
         }
 #else
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM)
+            SIMDSTORE(v1,_mm_or_si128(SIMDLOAD(v1),SIMDLOAD(v2)));
+#endif
         for (; v1 < vtop; v1++,v2++)
             *v1 |= *v2;
 #endif
@@ -505,6 +554,10 @@ void vec_or(vec_t v1,vec_t v2,vec_t v3)
         assert(v2 && v3);
         assert(vec_numbits(v1)==vec_numbits(v2) && vec_numbits(v1)==vec_numbits(v3));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM,v3 += SIMDDIM)
+            SIMDSTORE(v1,_mm_or_si128(SIMDLOAD(v2),SIMDLOAD(v3)));
+#endif
         for (; v1 < vtop; v1++,v2++,v3++)
                 *v1 = *v2 | *v3;
     }
@@ -524,6 +577,10 @@ void vec_subass(vec_t v1,vec_t v2)
         assert(v2);
         assert(vec_numbits(v1)==vec_numbits(v2));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM)
+            SIMDSTORE(v1,_mm_andnot_si128(SIMDLOAD(v2),SIMDLOAD(v1)));
+#endif
         for (; v1 < vtop; v1++,v2++)
             *v1 &= ~*v2;
     }
@@ -543,6 +600,10 @@ void vec_sub(vec_t v1,vec_t v2,vec_t v3)
         assert(v2 && v3);
         assert(vec_numbits(v1)==vec_numbits(v2) && vec_numbits(v1)==vec_numbits(v3));
         vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+        for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM,v3 += SIMDDIM)
+            SIMDSTORE(v1,_mm_andnot_si128(SIMDLOAD(v3),SIMDLOAD(v2)));
+#endif
         for (; v1 < vtop; v1++,v2++,v3++)
             *v1 = *v2 & ~*v3;
     }
@@ -612,6 +673,13 @@ int vec_disjoint(vec_t v1,vec_t v2)
     assert(v1 && v2);
     assert(vec_numbits(v1)==vec_numbits(v2));
     vtop = &v1[vec_dim(v1)];
+#if VEC_SIMD
+    for (; v1 + SIMDDIM <= vtop; v1 += SIMDDIM,v2 += SIMDDIM)
+    {   __m128i x = _mm_and_si128(SIMDLOAD(v1),SIMDLOAD(v2));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x,_mm_setzero_si128())) != 0xFFFF)
+            return 0;
+    }
+#endif
     for (; v1 < vtop; v1++,v2++)
         if (*v1 & *v2)
             return 0;
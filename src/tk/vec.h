@@ -74,6 +74,26 @@ void vec_println (vec_t v);
 #define vec_setbit(b, v)        _inline_bts(v, b)
 #define vec_clearbit(b, v)      _inline_btr(v, b)
 #define vec_testbit(b, v)       (v && _inline_bt(v, b))
+#elif __GNUC__ && !defined(DEBUG)
+// Inline the bit operations, as the optimizer's inner loops are made of them
+inline void vec_setbit_inline(size_t b, vec_t v)
+{
+    v[b >> VECSHIFT] |= (vec_base_t)1 << (b & VECMASK);
+}
+
+inline void vec_clearbit_inline(size_t b, vec_t v)
+{
+    v[b >> VECSHIFT] &= ~((vec_base_t)1 << (b & VECMASK));
+}
+
+inline size_t vec_testbit_inline(size_t b, vec_t v)
+{
+    return v ? v[b >> VECSHIFT] & ((vec_base_t)1 << (b & VECMASK)) : 0;
+}
+
+#define vec_setbit(b, v)        vec_setbit_inline(b, v)
+#define vec_clearbit(b, v)      vec_clearbit_inline(b, v)
+#define vec_testbit(b, v)       vec_testbit_inline(b, v)
 #endif
 
 #endif /* VEC_H */
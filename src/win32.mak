@@ -137,7 +137,7 @@ FRONTOBJ= enum.obj struct.obj dsymbol.obj import.obj id.obj \
 	module.obj scope.obj cond.obj inline.obj opover.obj \
 	entity.obj class.obj mangle.obj attrib.obj impcnvtab.obj \
 	link.obj access.obj doc.obj macro.obj hdrgen.obj delegatize.obj \
-	interpret.obj ctfeexpr.obj traits.obj aliasthis.obj \
+	interpret.obj ctfeexpr.obj ctfevm.obj traits.obj aliasthis.obj \
 	builtin.obj clone.obj arrayop.obj \
 	json.obj unittests.obj imphint.obj argtypes.obj apply.obj sapply.obj \
 	sideeffect.obj intrange.obj canthrow.obj target.obj
@@ -169,7 +169,7 @@ GCOBJS=rmem.obj
 #GCOBJS=dmgcmem.obj bits.obj win32.obj gc.obj
 ROOTOBJS= man.obj port.obj \
 	stringtable.obj response.obj async.obj speller.obj aav.obj outbuffer.obj \
-	object.obj filename.obj file.obj \
+	object.obj filename.obj file.obj thread.obj timetrace.obj \
 	$(GCOBJS)
 
 # D front end
@@ -184,7 +184,7 @@ SRCS= mars.c enum.c struct.c dsymbol.c import.c idgen.c impcnvgen.c utf.h \
 	mars.h module.h mtype.h dsymbol.h \
 	declaration.h lexer.h expression.h statement.h doc.h doc.c \
 	macro.h macro.c hdrgen.h hdrgen.c arraytypes.h \
-	delegatize.c interpret.c ctfeexpr.c traits.c builtin.c \
+	delegatize.c interpret.c ctfeexpr.c ctfevm.c traits.c builtin.c \
 	clone.c lib.h arrayop.c \
 	aliasthis.h aliasthis.c json.h json.c unittests.c imphint.c argtypes.c \
 	apply.c sapply.c sideeffect.c ctfe.h \
@@ -228,11 +228,14 @@ TKSRC= $(TK)\filespec.h $(TK)\mem.h $(TK)\list.h $(TK)\vec.h $(TKSRCC)
 ROOTSRCC=$(ROOT)\rmem.c $(ROOT)\stringtable.c \
 	$(ROOT)\man.c $(ROOT)\port.c $(ROOT)\async.c $(ROOT)\response.c \
 	$(ROOT)\speller.c $(ROOT)\aav.c $(ROOT)\longdouble.c \
-	$(ROOT)\outbuffer.c $(ROOT)\object.c $(ROOT)\filename.c $(ROOT)\file.c
+	$(ROOT)\outbuffer.c $(ROOT)\object.c $(ROOT)\filename.c $(ROOT)\file.c \
+	$(ROOT)\thread.c $(ROOT)\timetrace.c
 ROOTSRC= $(ROOT)\root.h \
 	$(ROOT)\rmem.h $(ROOT)\port.h \
 	$(ROOT)\stringtable.h \
 	$(ROOT)\async.h \
+	$(ROOT)\thread.h \
+	$(ROOT)\timetrace.h \
 	$(ROOT)\speller.h \
 	$(ROOT)\aav.h \
 	$(ROOT)\longdouble.h \
@@ -545,7 +548,7 @@ os.obj : $C\os.c
 	$(CC) -c $(MFLAGS) $C\os
 
 out.obj : $C\out.c
-	$(CC) -c $(MFLAGS) $C\out
+	$(CC) -c $(MFLAGS) -I$(ROOT) $C\out
 
 outbuf.obj : $C\outbuf.h $C\outbuf.c
 	$(CC) -c $(MFLAGS) $C\outbuf
@@ -642,6 +645,12 @@ speller.obj : $(ROOT)\speller.h $(ROOT)\speller.c
 stringtable.obj : $(ROOT)\stringtable.c
 	$(CC) -c $(CFLAGS) $(ROOT)\stringtable.c
 
+thread.obj : $(ROOT)\thread.h $(ROOT)\thread.c
+	$(CC) -c $(CFLAGS) $(ROOT)\thread.c
+
+timetrace.obj : $(ROOT)\timetrace.h $(ROOT)\timetrace.c
+	$(CC) -c $(CFLAGS) $(ROOT)\timetrace.c
+
 outbuffer.obj : $(ROOT)\outbuffer.c
 	$(CC) -c $(CFLAGS) $(ROOT)\outbuffer.c
 
@@ -698,6 +707,7 @@ init.obj : $(TOTALH) init.h init.c
 inline.obj : $(TOTALH) inline.c
 interpret.obj : $(TOTALH) interpret.c declaration.h expression.h ctfe.h
 ctfexpr.obj : $(TOTALH) ctfeexpr.c ctfe.h
+ctfevm.obj : $(TOTALH) ctfevm.c ctfe.h
 intrange.obj : $(TOTALH) intrange.h intrange.c
 json.obj : $(TOTALH) json.h json.c
 lexer.obj : $(TOTALH) lexer.c
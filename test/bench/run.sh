@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+
+# Time the 64 bit code dmd generates for the programs in this directory.
+#
+# usage: bench/run.sh [dmd [base_dmd]]
+#
+# Each program is built with -O -release -inline once for every processor
+# -mcpu=? lists, and the best of ${RUNS} runs is reported. -mcpu=none is the
+# unscheduled code to compare the others with. If base_dmd is given, the
+# code it generates without -mcpu= is timed as well. Every build of a
+# program must print the same checksum.
+
+DMD=${1:-../src/dmd}
+BASE_DMD=$2
+RUNS=${RUNS:-5}
+FLAGS="-m64 -O -release -inline"
+
+dir=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cpus=$($DMD "-mcpu=?" | sed -n 's/^ *=//p')
+if [ -z "$cpus" ]; then
+    echo "$DMD does not list any -mcpu= processors"
+    exit 1
+fi
+
+# usage: bench name dmd flags...
+# prints the best time in milliseconds and the checksum
+bench()
+{
+    local name=$1 dmd=$2
+    shift 2
+    local exe=$work/$name
+    $dmd $FLAGS "$@" -od$work -of$exe $dir/$name.d || return 1
+
+    local best= sum=
+    for ((r = 0; r < RUNS; r++)); do
+        local t0=$(date +%s%N)
+        local out=$($exe)
+        local t1=$(date +%s%N)
+        local ms=$(( (t1 - t0) / 1000000 ))
+        if [ -n "$sum" ] && [ "$out" != "$sum" ]; then
+            echo "checksum changed between runs"
+            return 1
+        fi
+        sum=$out
+        if [ -z "$best" ] || [ $ms -lt $best ]; then
+            best=$ms
+        fi
+    done
+    echo "$best $sum"
+}
+
+status=0
+printf "%-8s %-12s %8s  %s\n" program cpu ms checksum
+for f in $dir/*.d; do
+    name=$(basename $f .d)
+    expect=
+
+    configs=
+    if [ -n "$BASE_DMD" ]; then
+        configs="base"
+    fi
+    for cpu in $cpus; do
+        configs="$configs $cpu"
+    done
+
+    for config in $configs; do
+        if [ $config = base ]; then
+            result=$(bench $name $BASE_DMD)
+        else
+            result=$(bench $name $DMD -mcpu=$config)
+        fi
+        if [ $? -ne 0 ]; then
+            echo "$name: $config: $result"
+            status=1
+            continue
+        fi
+        set -- $result
+        mark=
+        if [ -z "$expect" ]; then
+            expect=$2
+        elif [ "$2" != "$expect" ]; then
+            mark="  MISMATCH"
+            status=1
+        fi
+        printf "%-8s %-12s %8s  %s%s\n" $name $config $1 $2 "$mark"
+    done
+done
+exit $status
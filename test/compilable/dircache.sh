@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+
+dir=${RESULTS_DIR}/compilable
+src=compilable/extra-files
+output_file=${dir}/dircache.sh.out
+
+rm -f ${output_file}
+
+# A module missing from a directory that has been listed is not found
+$DMD -m${MODEL} -o- -I${src}/dircache2 ${src}/dircachemissing.d > ${output_file}.2 2>&1 && exit 1
+if ! grep -q "module dcmissing is in file 'dcmissing.d' which cannot be read" ${output_file}.2; then
+    cat ${output_file}.2
+    exit 1
+fi
+
+# The listing finds a name in another case only where the file system would
+$DMD -m${MODEL} -o- -I${src}/dircache2 ${src}/dircachecase.d > ${output_file}.2 2>&1
+if [ -f ${src}/dircache2/DCB.d ]; then
+    if grep -q "cannot be read" ${output_file}.2; then
+        cat ${output_file}.2
+        echo "Error: DCB.d not found on a file system that ignores case"
+        exit 1
+    fi
+elif ! grep -q "module DCB is in file 'DCB.d' which cannot be read" ${output_file}.2; then
+    cat ${output_file}.2
+    echo "Error: DCB.d found on a file system that is case sensitive"
+    exit 1
+fi
+
+rm ${output_file}.2
+
+echo Success >${output_file}
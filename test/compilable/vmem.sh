@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+
+dir=${RESULTS_DIR}/compilable
+output_file=${dir}/vmem.sh.out
+
+rm -f ${output_file}
+
+$DMD -m${MODEL} -c -od${dir} -vmem compilable/extra-files/vmem.d > ${output_file}.2 || exit 1
+
+# Every phase reports its total and its share of each kind of allocation
+for phase in parse importall semantic semantic2 semantic3 codegen; do
+    if ! grep -q "^memory    ${phase} *[0-9]* kB$" ${output_file}.2; then
+        cat ${output_file}.2
+        echo "Error: no -vmem report after ${phase}"
+        exit 1
+    fi
+done
+for kind in other tokens expressions types dsymbols "template instances" "ctfe values" "backend elems"; do
+    if [ `grep -c "^memory      ${kind} *[0-9]* kB *[0-9]* objects" ${output_file}.2` -ne 6 ]; then
+        cat ${output_file}.2
+        echo "Error: -vmem doesn't report ${kind} after each phase"
+        exit 1
+    fi
+done
+
+rm ${output_file}.2 ${dir}/vmem${OBJ}
+
+echo Success >${output_file}
@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+
+src=runnable${SEP}extra-files
+dir=${RESULTS_DIR}${SEP}runnable
+output_file=${dir}/jobs.sh.out
+
+# Generate the object files on several processes, then link them
+$DMD -m${MODEL} -I${src} -od${dir} -c -j=3 ${src}${SEP}jobsmain.d ${src}${SEP}jobsa.d ${src}${SEP}jobsb.d || exit 1
+$DMD -m${MODEL} -of${dir}${SEP}jobs${EXE} ${dir}${SEP}{jobsmain${OBJ},jobsa${OBJ},jobsb${OBJ}} || exit 1
+${dir}${SEP}jobs${EXE} || exit 1
+
+rm ${dir}/{jobsmain${OBJ},jobsa${OBJ},jobsb${OBJ},jobs${EXE}}
+
+# An error in one worker must not leave the others' object files behind
+if $DMD -m${MODEL} -I${src} -od${dir} -c -j=3 ${src}${SEP}jobsmain.d ${src}${SEP}jobsa.d ${src}${SEP}jobsbad.d 2>/dev/null; then
+    echo "jobsbad.d compiled"
+    exit 1
+fi
+for m in jobsmain jobsa jobsbad; do
+    if [ -e ${dir}/${m}${OBJ} ]; then
+        echo "${m}${OBJ} was not deleted"
+        exit 1
+    fi
+done
+
+echo Success >${output_file}
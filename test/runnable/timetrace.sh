@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+
+src=runnable${SEP}extra-files
+dir=${RESULTS_DIR}${SEP}runnable
+output_file=${dir}/timetrace.sh.out
+trace_file=${dir}${SEP}timetrace.json
+
+rm -f ${trace_file}
+
+$DMD -m${MODEL} -od${dir} -of${dir}${SEP}timetrace${EXE} -ftime-trace -ftime-trace-granularity=0 -ftime-trace-file=${trace_file} ${src}${SEP}timetrace.d || exit 1
+${dir}${SEP}timetrace${EXE} ${trace_file} || exit 1
+
+rm ${dir}/{timetrace${OBJ},timetrace${EXE}} ${trace_file}
+
+echo Success >${output_file}